@@ -0,0 +1,34 @@
+/*
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Public interface for persistent configuration
+===============================================================================
+*/
+
+#ifndef CFG_H_
+#define CFG_H_
+
+#include "sys.h"
+
+#define CFG_EEP_ADDR	0x10	// address in EEPROM where config block is stored, up to 0xFF
+
+// state of the stored config block
+typedef enum
+{
+	CFG_STATE_SAVED		= 0u,	// EEPROM matches current settings
+	CFG_STATE_PENDING	= 1u,	// settings changed, written once they are stable
+	CFG_STATE_DEFAULTS	= 2u,	// no valid block found at boot, nothing written yet
+} CFG_State_t;
+
+// public function declarations
+void CFG_Init(void);
+void CFG_Tick(void);
+void CFG_Save(void);
+void CFG_Reset(void);
+CFG_State_t CFG_GetState(void);
+byte CFG_GetVersion(void);
+
+#endif /* CFG_H_ */
@@ -0,0 +1,22 @@
+/*
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Public interface for interrupt driven EEPROM access
+===============================================================================
+*/
+
+#ifndef EEP_H_
+#define EEP_H_
+
+#include "sys.h"
+
+// public function declarations
+void EEP_Write(uint16_t addr, const void *data, byte len);
+void EEP_Read(uint16_t addr, void *data, byte len);
+void EEP_Flush(void);
+bool EEP_Busy(void);
+
+#endif /* EEP_H_ */
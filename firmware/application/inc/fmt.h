@@ -0,0 +1,26 @@
+/*
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Public interface for fixed-point number formatting
+===============================================================================
+*/
+
+#ifndef FMT_H_
+#define FMT_H_
+
+#include "sys.h"
+
+#define FMT_BUF_SIZE	20u		// fits any formatted value incl. unit & terminating zero
+
+// public function declarations
+byte FMT_Fixed(char *buf, uint32_t value, byte scale, byte decimals);
+byte FMT_FixedSigned(char *buf, int32_t value, byte scale, byte decimals);
+byte FMT_FixedQ(char *buf, int32_t value, byte frac_bits, byte decimals);
+byte FMT_Dose(char *buf, uint32_t dose);
+byte FMT_DoseRate(char *buf, uint32_t rate);
+byte FMT_Time(char *buf, byte hours, byte mins, byte secs);
+
+#endif /* FMT_H_ */
@@ -13,16 +13,6 @@
 
 #include "sys.h"
 
-// GPIO pin property struct
-typedef struct
-{
-	// 7 bits total
-	byte port	: 2;	// register block	(B/C/D/E)
-	byte n		: 3;	// pin number		(0..7)
-	bool dir	: 1;	// direction		(0=in/1=out)
-	bool init	: 1;	// default state	(0=lo/1=hi)
-} GPIO_PinStruct_t;
-
 // GPIO port enum
 typedef enum
 {
@@ -32,70 +22,108 @@ typedef enum
 	PE = 3u
 } GPIO_Port_t;
 
+// pin properties are encoded in the pin name, resolved at compile time
+// bits 0..2: pin number, 3..4: port, 5: direction (0=in/1=out), 6: default state (0=lo/1=hi)
+#define GPIO_PIN(port, n, dir, init)	(((init) << 6) | ((dir) << 5) | ((port) << 3) | (n))
+#define GPIO_PIN_N(pin)		((pin) & 0x07)
+#define GPIO_PIN_PORT(pin)	(((pin) >> 3) & 0x03)
+#define GPIO_PIN_DIR(pin)	((bool)((pin) & 0x20))
+#define GPIO_PIN_INIT(pin)	((bool)((pin) & 0x40))
+
 // pin names
 typedef enum
 {
-	PIN_RAD_IMP		= 0u,
-	PIN_VREG_EN		= 1u,
-	PIN_RFU1		= 2u, // reserved for future use
-	PIN_RFU2		= 3u,
-	PIN_KEY_GRN		= 4u,
-	PIN_KEY_YEL		= 5u,
-	PIN_KEY_RED		= 6u,
-	PIN_RFU3		= 7u,
-	PIN_HV_EN		= 8u,
-	PIN_BEEP_EN		= 9u,
-	PIN_SPI_MOSI	= 10u,
-	PIN_SPI_MISO	= 11u,
-	PIN_SPI_SCK		= 12u,
-	PIN_RFU4		= 13u,
-	PIN_CLICK_EN	= 14u,
-	PIN_BAT_STAT	= 15u,
-	PIN_LCD_RS		= 16u,
-	PIN_LCD_CS		= 17u,
-	PIN_HV_GATE		= 18u,
-	PIN_RFU5		= 19u,
-	PIN_UART_RX		= 20u,
-	PIN_UART_TX		= 21u,
-	PIN_VUSB		= 22u,
-	PIN_NUM			= 23u // needs to be the last one
+	PIN_RAD_IMP		= GPIO_PIN(PD, 3u, IN, LO),		// PD3 - IMP_INT
+	PIN_VREG_EN		= GPIO_PIN(PD, 4u, OUT, HI),	// PD4 - PWR_EN
+	PIN_RFU1		= GPIO_PIN(PE, 0u, IN, HI),		// PE0 - [unused], reserved for future use
+	PIN_RFU2		= GPIO_PIN(PE, 1u, IN, HI),		// PE1 - [unused]
+	PIN_KEY_GRN		= GPIO_PIN(PD, 5u, IN, LO),		// PD5 - KEY_GRN
+	PIN_KEY_YEL		= GPIO_PIN(PD, 6u, IN, LO),		// PD6 - KEY_YEL
+	PIN_KEY_RED		= GPIO_PIN(PD, 7u, IN, LO),		// PD7 - KEY_RED
+	PIN_RFU3		= GPIO_PIN(PB, 0u, IN, HI),		// PB0 - [unused]
+	PIN_HV_EN		= GPIO_PIN(PB, 1u, OUT, LO),	// PB1 - HV_EN
+	PIN_BEEP_EN		= GPIO_PIN(PB, 2u, OUT, LO),	// PB2 - IMP_BEEP_EN
+	PIN_SPI_MOSI	= GPIO_PIN(PB, 3u, OUT, HI),	// PB3 - LCD_SI
+	PIN_SPI_MISO	= GPIO_PIN(PB, 4u, IN, LO),		// PB4 - MISO
+	PIN_SPI_SCK		= GPIO_PIN(PB, 5u, OUT, HI),	// PB5 - LCD_CLK
+	PIN_RFU4		= GPIO_PIN(PE, 2u, IN, HI),		// PE2 - [unused]
+	PIN_CLICK_EN	= GPIO_PIN(PC, 0u, OUT, LO),	// PC0 - IMP_CLICK_EN
+	PIN_BAT_STAT	= GPIO_PIN(PC, 1u, IN, LO),		// PC1 - BAT_STAT
+	PIN_LCD_RS		= GPIO_PIN(PC, 2u, OUT, HI),	// PC2 - LCD_RS
+	PIN_LCD_CS		= GPIO_PIN(PC, 3u, OUT, HI),	// PC3 - LCD_CS
+	PIN_HV_GATE		= GPIO_PIN(PC, 4u, IN, LO),		// PC4 - HV_MON
+	PIN_RFU5		= GPIO_PIN(PC, 5u, IN, HI),		// PC5 - [unused]
+	PIN_UART_RX		= GPIO_PIN(PD, 0u, IN, LO),		// PD0 - RX
+	PIN_UART_TX		= GPIO_PIN(PD, 1u, OUT, HI),	// PD1 - TX
+	PIN_VUSB		= GPIO_PIN(PD, 2u, IN, LO),		// PD2 - VUSB
 } GPIO_Pin_t;
 
-// pin name mapping
-static const __flash GPIO_PinStruct_t gpio[PIN_NUM] =
-{
-	// port, pin, dir, init
-	{PD,3u,IN,LO},	// PD3 - IMP_INT
-	{PD,4u,OUT,HI}, // PD4 - PWR_EN
-	{PE,0u,IN,HI},	// PE0 - [unused]
-	{PE,1u,IN,HI},	// PE1 - [unused]
-	{PD,5u,IN,LO},	// PD5 - KEY_GRN
-	{PD,6u,IN,LO},	// PD6 - KEY_YEL
-	{PD,7u,IN,LO},	// PD7 - KEY_RED
-	{PB,0u,IN,HI},	// PB0 - [unused]
-	{PB,1u,OUT,LO}, // PB1 - HV_EN
-	{PB,2u,OUT,LO}, // PB2 - IMP_BEEP_EN
-	{PB,3u,OUT,HI}, // PB3 - LCD_SI
-	{PB,4u,IN,LO},	// PB4 - MISO
-	{PB,5u,OUT,HI}, // PB5 - LCD_CLK
-	{PE,2u,IN,HI},	// PE2 - [unused]
-	{PC,0u,OUT,LO}, // PC0 - IMP_CLICK_EN
-	{PC,1u,IN,LO},  // PC1 - BAT_STAT
-	{PC,2u,OUT,HI}, // PC2 - LCD_RS
-	{PC,3u,OUT,HI}, // PC3 - LCD_CS
-	{PC,4u,IN,LO},	// PC4 - HV_MON
-	{PC,5u,IN,HI},	// PC5 - [unused]
-	{PD,0u,IN,LO},	// PD0 - RX
-	{PD,1u,OUT,HI}, // PD1 - TX
-	{PD,2u,IN,LO},	// PD2 - VUSB
-};
+// compile-time direction check: calls to these are only left if a constant pin is used against its direction
+// needs optimization, which is always enabled (-Os)
+void GPIO_ErrorNotOutput(void) __attribute__((error("pin is not an output")));
+void GPIO_ErrorNotInput(void) __attribute__((error("pin is not an input")));
+#ifdef __OPTIMIZE__
+#define GPIO_CHECK_DIR(pin, dir) \
+	if (__builtin_constant_p(pin) && (GPIO_PIN_DIR(pin) != (dir))) { if (dir) { GPIO_ErrorNotOutput(); } else { GPIO_ErrorNotInput(); } }
+#else
+#define GPIO_CHECK_DIR(pin, dir)
+#endif
 
 // public function declarations
 void GPIO_Init(void);
-void GPIO_ConfigPin(byte gpiopin, bool state);
-void GPIO_SetPin(byte gpiopin, bool state);
-bool GPIO_GetPin(byte gpiopin);
-void GPIO_PullupPin(byte gpiopin, bool enable);
-void GPIO_TogglePin(byte gpiopin);
+
+// select register of a pin's port, folds to a constant address for constant pins
+static inline __attribute__((always_inline)) sfr* GPIO_Reg(GPIO_Pin_t pin, sfr *b, sfr *c, sfr *d, sfr *e)
+{
+	switch (GPIO_PIN_PORT(pin))
+	{
+		case PB: { return b; }
+		case PC: { return c; }
+		case PD: { return d; }
+		default: { return e; }
+	}
+}
+
+// the functions below compile to single SBI/CBI/SBIS/SBIC instructions for constant pins & states
+
+// configure pin as input or output, must match the direction of the pin name
+static inline __attribute__((always_inline)) void GPIO_ConfigPin(GPIO_Pin_t pin, bool dir)
+{
+	sfr *ddr = GPIO_Reg(pin, &DDRB, &DDRC, &DDRD, &DDRE);
+	if (dir) { SET(*ddr, GPIO_PIN_N(pin)); }
+	else { CLR(*ddr, GPIO_PIN_N(pin)); }
+}
+
+// set output pin state
+static inline __attribute__((always_inline)) void GPIO_SetPin(GPIO_Pin_t pin, bool state)
+{
+	GPIO_CHECK_DIR(pin, OUT);
+	sfr *port = GPIO_Reg(pin, &PORTB, &PORTC, &PORTD, &PORTE);
+	if (state) { SET(*port, GPIO_PIN_N(pin)); }
+	else { CLR(*port, GPIO_PIN_N(pin)); }
+}
+
+// get input pin state
+static inline __attribute__((always_inline)) bool GPIO_GetPin(GPIO_Pin_t pin)
+{
+	GPIO_CHECK_DIR(pin, IN);
+	return GET(*GPIO_Reg(pin, &PINB, &PINC, &PIND, &PINE), GPIO_PIN_N(pin));
+}
+
+// enable or disable pull-up resistor on input pin
+static inline __attribute__((always_inline)) void GPIO_PullupPin(GPIO_Pin_t pin, bool enable)
+{
+	GPIO_CHECK_DIR(pin, IN);
+	sfr *port = GPIO_Reg(pin, &PORTB, &PORTC, &PORTD, &PORTE);
+	if (enable) { SET(*port, GPIO_PIN_N(pin)); }
+	else { CLR(*port, GPIO_PIN_N(pin)); }
+}
+
+// toggle output pin, writing one to PINx toggles the bit & leaves the others alone
+static inline __attribute__((always_inline)) void GPIO_TogglePin(GPIO_Pin_t pin)
+{
+	GPIO_CHECK_DIR(pin, OUT);
+	*GPIO_Reg(pin, &PINB, &PINC, &PIND, &PINE) = BV(GPIO_PIN_N(pin));
+}
 
 #endif /* GPIO_H_ */
\ No newline at end of file
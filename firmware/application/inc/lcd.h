@@ -25,11 +25,17 @@ typedef enum
 	LCD_NUM_SYMBOLS		= 8,	// number of symbols
 } LCD_Symbol_t;
 
+// format string literal is kept in flash, it would be copied to RAM otherwise
+#define LCD_Printf(line, formatstr, ...)	LCD_PrintfP(line, PSTR(formatstr), ##__VA_ARGS__)
+
 // public function declarations
 void LCD_Init(void);
 void LCD_Enable(bool on);
 void LCD_Clear(void);
-void LCD_Printf(uint8_t line, const char *formatstr, ...);
+void LCD_Flush(void);
+bool LCD_Busy(void);
+void LCD_PrintfP(uint8_t line, const char *formatstr, ...);
+void LCD_PrintStr(uint8_t line, const char *str);
 void LCD_PrintChar(uint8_t line, uint8_t column, char character);
 void LCD_Position(uint8_t line, uint8_t column);
 
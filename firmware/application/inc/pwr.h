@@ -15,7 +15,6 @@
 #include "sys.h"
 
 void PWR_Init(void);
-bool PWR_CheckUsbEvent(void);
 void PWR_SleepMode(void);
 void PWR_Reset(void);
 void PWR_Shutdown(void);
@@ -13,25 +13,110 @@
 
 #include "sys.h"
 
-#define RAD_DOSE_EEP_ADDR	0x01	// address in EEPROM where total dose rate is stored
+#define RAD_DOSE_EEP_ADDR	0x01	// total dose float of older firmware, read if the dose journal is empty
+#define RAD_DEAD_TIME_EEP_ADDR	0x05	// calibrated dead time in us, uint16
+#define RAD_IHIST_NUM		42u		// pulse interval histogram: <32us, 40 half-octaves up to 33.5s, >=33.5s
+
+// inter-arrival statistics of captured pulses, times in us
+typedef struct
+{
+	uint32_t count;		// pulses captured since capture was enabled
+	uint32_t minInterval;
+	uint32_t lastInterval;
+	uint16_t drops;		// pulses lost due to full capture buffer
+	uint16_t linkDrops;	// streamed pulses lost due to full UART TX buffer
+} RAD_PulseStats_t;
+
+#define RAD_HV_STATS_Q		3u		// fractional bits of EWMA & drift in RAD_HvStats_t
+
+// long-term statistics of HV gate edges per second, drift is estimated from hourly EWMA snapshots
+typedef struct
+{
+	uint16_t last, min, max;
+	uint16_t ewma;		// Q3; fits RAD_HV_MAX_PULSES with margin, see RAD_HV_STATS_Q
+	int16_t drift;		// Q3; [1/d]
+	uint16_t samples;
+	bool warning;		// load drifts or last sample far off EWMA
+} RAD_HvStats_t;
+
+// pulse capture owners, capture runs while at least one of them holds it
+typedef enum
+{
+	RAD_CAP_USER	= 0x01u,	// 'p' command, owns the pulse stream
+	RAD_CAP_SEED	= 0x02u,	// DRBG seeding
+	RAD_CAP_BULK	= 0x04u,	// RNG bulk output
+	RAD_CAP_DTCAL	= 0x08u,	// dead-time calibration
+	RAD_CAP_ALL		= 0x0Fu,
+} RAD_CaptureOwner_t;
+
+// boxcar averaging windows
+typedef enum
+{
+	RAD_AVG_10S		= 0u,
+	RAD_AVG_1MIN	= 1u,
+	RAD_AVG_10MIN	= 2u,
+	RAD_AVG_1H		= 3u,
+	RAD_AVG_NUM		= 4u,
+} RAD_AvgWindow_t;
+
+// dead-time models
+typedef enum
+{
+	RAD_DT_NONPARALYZABLE	= 0u,	// m = n/(1+n*t)
+	RAD_DT_PARALYZABLE		= 1u,	// m = n*exp(-n*t)
+	RAD_DT_HYBRID			= 2u,	// m = n*exp(-n*t/2)/(1+n*t/2)
+	RAD_DT_MODEL_NUM		= 3u,
+} RAD_DeadTimeModel_t;
+
+// state of a one sided CUSUM change detector
+typedef struct
+{
+	uint32_t s;		// Q16; accumulated log-likelihood ratio
+	uint32_t sum;	// Q8; sum of CPS samples since s left zero
+	uint8_t len;	// number of samples in sum
+} RAD_Cusum_t;
 
 // externally visible variables
-#define RAD_FILTER_LVL_NUM	3u
-extern const float RAD_filterLvls[RAD_FILTER_LVL_NUM];
-extern float RAD_filterFactor;
+// filter factors are Q16 fractions, dose rates are returned in nSv/h, total doses in nSv
+// factor 0 selects the adaptive filter, averaging window length follows detected rate changes
+#define RAD_FILTER_LVL_NUM	4u
+#define RAD_FILTER_ADAPTIVE	0u
+extern const uint16_t RAD_filterLvls[RAD_FILTER_LVL_NUM];
+extern uint16_t RAD_filterFactor;
+extern RAD_DeadTimeModel_t RAD_deadTimeModel;
 extern uint16_t RAD_uartLogInterval;
+extern bool RAD_uartLogBinary;
 
 // public function declarations
 bool RAD_Init(void);
-bool RAD_CheckHv(uint16_t *counts);
+void RAD_RequestHvCheck(void);
+uint16_t RAD_GetHvCounts(void);
+RAD_HvStats_t RAD_GetHvStats(void);
 bool RAD_DetectorCheck(void);
 bool RAD_GetFault(void);
+bool RAD_GetOverRange(void);
 void RAD_EngineTick(void);
 void RAD_UpdateBuffer(void);
-float RAD_GetDoseRate(void);
-void RAD_SetTotalDose(float dose);
-float RAD_GetTotalDose(void);
+uint32_t RAD_GetDoseRate(void);
+byte RAD_GetDoseRateErr(void);
+void RAD_SetTotalDose(uint32_t dose);
+uint32_t RAD_GetTotalDose(void);
 void RAD_SaveTotalDose(void);
+void RAD_SetCapture(RAD_CaptureOwner_t owner, bool enable);
+bool RAD_GetCapture(void);
+void RAD_ProcessPulses(void);
+void RAD_SetPulseStream(bool enable);
+RAD_PulseStats_t RAD_GetPulseStats(void);
+void RAD_StartDeadTimeCal(void);
+bool RAD_GetDeadTimeCal(uint32_t *samples);
+uint16_t RAD_GetDeadTime(void);
+bool RAD_SetDeadTime(uint16_t dead_time);
+uint16_t RAD_GetIntervalHist(byte bin);
+void RAD_ResetIntervalHist(void);
+uint32_t RAD_GetIntervalHistBin(byte bin);
+void RAD_SetAlarmLevel(uint32_t rate);
+bool RAD_CheckRateAlarm(void);
+bool RAD_GetAvgDoseRate(RAD_AvgWindow_t win, uint32_t *rate);
 void RAD_DeInit(void);
 
 #endif /* RAD_H_ */
\ No newline at end of file
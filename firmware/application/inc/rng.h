@@ -0,0 +1,42 @@
+/*
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Public interface for the GM tube random number generator & DRBG
+===============================================================================
+*/
+
+#ifndef RNG_H_
+#define RNG_H_
+
+#include "sys.h"
+
+// entropy pipeline & bulk output statistics
+typedef struct
+{
+	uint32_t rawBits;	// comparison bits seen by the health tests
+	uint32_t bits;		// debiased bits output in bulk mode
+	uint32_t time;		// [s]; duration of bulk mode
+	uint16_t failures;	// health test failures since boot
+	byte pool;			// bytes available
+	bool ready;			// startup test passed, output enabled
+	bool seeded;		// DRBG got its first full seed
+	uint16_t reseeds;
+	uint32_t reseedAge;	// [s]; since last reseed
+	uint16_t pending;	// requested DRBG bytes not sent yet
+} RNG_Stats_t;
+
+// public function declarations
+void RNG_AddInterval(uint32_t interval);
+bool RNG_GetBytes(void *data, byte len);
+bool RNG_GetDrbgBytes(void *data, byte len);
+bool RNG_Request(uint16_t len);
+void RNG_ProcessRequest(void);
+void RNG_SetBulk(bool enable);
+bool RNG_GetBulk(void);
+void RNG_Tick(void);
+RNG_Stats_t RNG_GetStats(void);
+
+#endif /* RNG_H_ */
@@ -27,7 +27,6 @@ uint32_t RTC_GetUpTime(void);
 void RTC_SetSysTime(RTC_Time_t time);
 RTC_Time_t RTC_GetSysTime(void);
 uint32_t RTC_GetSecTime(void);
-bool RTC_CheckSecTick(void);
 void RTC_DeInit(void);
 
 #endif /* TIMER_H_ */
\ No newline at end of file
@@ -22,16 +22,21 @@
 #include <math.h>
 #include <util/delay.h>
 #include <util/atomic.h>
+#include <util/crc16.h>
 #include <avr/io.h>
 #include <avr/eeprom.h>
 #include <avr/wdt.h>
 #include <avr/interrupt.h>
 #include <avr/sleep.h>
+#include <avr/pgmspace.h>
 
 // public defines
 #define SYS_ASSERT_LVL	1u	// assert handling strategy: 0=off, 1=warn, 2=reset
 #define SYS_EXCEPTION() SYS_Assert(false)
 
+// set pending main loop event, only to be used in ISRs or with interrupts disabled
+#define SYS_SET_EVENT(evt)	(SYS_pendingEvents |= (evt))
+
 // logic defines
 #define IN	false
 #define OUT true
@@ -53,7 +58,23 @@
 typedef uint8_t byte;
 typedef volatile uint8_t sfr;
 
+// main loop events, pending bits are set by the ISR of the source
+typedef enum
+{
+	SYS_EVT_SEC_TICK	= 0x01u,	// T2 OVF, every second
+	SYS_EVT_UART_RX		= 0x02u,	// LF or frame error received
+	SYS_EVT_KEYS		= 0x04u,	// key event available
+	SYS_EVT_USB			= 0x08u,	// USB dis/connected
+	SYS_EVT_PULSES		= 0x10u,	// pulse timestamps captured
+	SYS_EVT_RATE_ALARM	= 0x20u,	// count limit exceeded in quarter second alarm window
+	SYS_EVT_UART_TX		= 0x40u,	// TX buffer drained to low water mark
+} SYS_Event_t;
+
+// externally visible variables
+extern volatile byte SYS_pendingEvents;
+
 // public function declarations
 void SYS_Assert(bool ok);
+byte SYS_GetEvents(void);
 
 #endif /* SYS_H_ */
\ No newline at end of file
@@ -18,14 +18,22 @@
 #define UART_BAUDRATE			28800u
 
 #define UART_TX_BUF_SIZE		256u
-#define UART_PRINT_BUF_SIZE		64u
+#define UART_PRINT_BUF_SIZE		64u		// TX buffer space binary frames leave free for text output
 #define UART_RX_BUF_SIZE		32u
+#define UART_FRAME_MAX			64u		// max payload of a binary frame
+#define UART_TX_LOW_WATER		64u		// TX event when buffer drains to this level, ~22ms left to refill
+
+// format string literal is kept in flash, it would be copied to RAM otherwise
+#define UART_Printf(formatstr, ...)	UART_PrintfP(PSTR(formatstr), ##__VA_ARGS__)
 
 // public function declarations
 bool UART_Init(void);
-void UART_Printf(const char *formatstr, ...);
+void UART_PrintfP(const char *formatstr, ...);
+bool UART_FrameFits(byte len);
+bool UART_SendFrame(const byte *data, byte len);
 bool UART_RxString(char* buffer);
 bool UART_TxBusy(void);
+bool UART_TxSleep(void);
 byte UART_CalcUbrr(uint32_t f_real);
 bool UART_SetUbrr(byte ubrr, bool write_to_eep);
 void UART_Enable(bool en);
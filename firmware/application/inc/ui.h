@@ -20,8 +20,9 @@ typedef enum
 	UI_VIEW_TIME		= 2u,
 	UI_VIEW_ALARM		= 3u,
 	UI_VIEW_VOLTS		= 4u,
-	UI_NUM_VIEW_MODES	= 5u,
-	UI_VIEW_FAULT		= 6u, // this one is not accessible by keys
+	UI_VIEW_AVERAGE		= 5u,
+	UI_NUM_VIEW_MODES	= 6u,
+	UI_VIEW_FAULT		= 7u, // this one is not accessible by keys
 } UI_viewMode_t;
 
 // externally visible variables
@@ -37,6 +38,7 @@ void UI_HandleKeys(byte key);
 void UI_RenderLcd(void);
 void UI_UpdateBattery(void);
 void UI_CheckAlarm(void);
+void UI_RateAlarm(void);
 void UI_EmitBeep(uint16_t ms);
 
 #endif /* UI_H_ */
\ No newline at end of file
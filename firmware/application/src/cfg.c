@@ -0,0 +1,184 @@
+/*
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Implementation of persistent configuration
+===============================================================================
+*/
+
+#include "cfg.h"
+//---------------
+#include "eep.h"
+#include "gpio.h"
+#include "rad.h"
+#include "ui.h"
+
+// internal defines
+#define CFG_VERSION		1u		// increment if the meaning of a stored field changes
+#define CFG_WRITE_DELAY	10u		// [s]; changed settings must be stable this long before they are written
+
+// config block as stored in EEPROM
+// fields are only ever appended, blocks of older versions are shorter & the missing fields keep their defaults
+typedef struct
+{
+	uint16_t crc;			// CRC-CCITT of all following bytes up to size
+	byte version;			// CFG_VERSION when written
+	byte size;				// bytes written, incl. header
+	float alarmLevel;		// [uSv/h]
+	uint16_t filterFactor;	// Q16; 0 = adaptive
+	uint16_t logInterval;	// [s]
+	byte viewMode;
+	byte deadTimeModel;
+	byte clickEnable;
+	byte logBinary;
+} CFG_Data_t;
+
+// internal variables
+static CFG_Data_t cfgDefaults;	// settings after module init, restored by CFG_Reset()
+static CFG_Data_t cfgSaved;		// settings stored in EEPROM
+static CFG_Data_t cfgChanged;	// last seen settings that differ from cfgSaved
+static byte cfgStableSecs;		// [s]; cfgChanged has not changed for this long
+static CFG_State_t cfgState;
+
+// internal function prototypes
+static void Collect(CFG_Data_t *cfg);
+static void Apply(const CFG_Data_t *cfg);
+static void Migrate(CFG_Data_t *cfg);
+static uint16_t Crc(const CFG_Data_t *cfg, byte size);
+
+// load config block from EEPROM & apply it, call this after all modules with settings are initialized
+// defaults are taken from the current settings
+void CFG_Init(void)
+{
+	Collect(&cfgDefaults);
+	cfgSaved = cfgDefaults;
+	cfgState = CFG_STATE_DEFAULTS;
+	
+	// header first, then as many bytes as were written
+	CFG_Data_t cfg;
+	EEP_Read(CFG_EEP_ADDR, &cfg, offsetof(CFG_Data_t, alarmLevel));
+	if ((cfg.version > CFG_VERSION) || (cfg.size < offsetof(CFG_Data_t, alarmLevel))) { return; } // erased or newer firmware
+	
+	byte size = (cfg.size < sizeof(cfg)) ? cfg.size : sizeof(cfg);
+	cfg = cfgDefaults;
+	EEP_Read(CFG_EEP_ADDR, &cfg, size);
+	
+	// CRC covers all bytes that were written, even fields unknown to this firmware
+	uint16_t crc = Crc(&cfg, size);
+	if (size < cfg.size)
+	{
+		byte extra;
+		for (byte i=size; i<cfg.size; i++)
+		{
+			EEP_Read(CFG_EEP_ADDR + i, &extra, 1);
+			crc = _crc_ccitt_update(crc, extra);
+		}
+	}
+	if (crc != cfg.crc) { return; }
+	
+	Migrate(&cfg);
+	Apply(&cfg);
+	Collect(&cfgSaved); // invalid fields were replaced by defaults
+	cfgState = (memcmp(&cfgSaved, &cfg, sizeof(cfg)) || (cfg.size != sizeof(cfg))) ? CFG_STATE_PENDING : CFG_STATE_SAVED;
+}
+
+// check for changed settings, call this every second
+// settings are written once they did not change for CFG_WRITE_DELAY, e.g. while cycling through view modes with keys
+void CFG_Tick(void)
+{
+	CFG_Data_t cfg;
+	Collect(&cfg);
+	
+	if (!memcmp(&cfg, &cfgSaved, sizeof(cfg)) && (cfgState != CFG_STATE_PENDING)) { return; }
+	
+	if (memcmp(&cfg, &cfgChanged, sizeof(cfg)))
+	{
+		cfgChanged = cfg;
+		cfgStableSecs = 0;
+		cfgState = CFG_STATE_PENDING;
+	}
+	else if (++cfgStableSecs >= CFG_WRITE_DELAY)
+	{
+		CFG_Save();
+	}
+}
+
+// write current settings to EEPROM, only changed bytes are actually written
+void CFG_Save(void)
+{
+	Collect(&cfgSaved);
+	cfgChanged = cfgSaved;
+	EEP_Write(CFG_EEP_ADDR, &cfgSaved, sizeof(cfgSaved));
+	cfgState = CFG_STATE_SAVED;
+}
+
+// restore default settings & save them
+void CFG_Reset(void)
+{
+	Apply(&cfgDefaults);
+	CFG_Save();
+}
+
+// get state of the stored config block
+CFG_State_t CFG_GetState(void)
+{
+	return cfgState;
+}
+
+// get version of the config block layout
+byte CFG_GetVersion(void)
+{
+	return CFG_VERSION;
+}
+
+// gather current settings from all modules, header & CRC included
+static void Collect(CFG_Data_t *cfg)
+{
+	cfg->version = CFG_VERSION;
+	cfg->size = sizeof(*cfg);
+	cfg->alarmLevel = UI_alarmLevel;
+	cfg->filterFactor = RAD_filterFactor;
+	cfg->logInterval = RAD_uartLogInterval;
+	cfg->deadTimeModel = RAD_deadTimeModel;
+	cfg->clickEnable = UI_clickEnable;
+	cfg->logBinary = RAD_uartLogBinary;
+	
+	// fault view is not a setting, keep last one
+	cfg->viewMode = (UI_viewMode < UI_NUM_VIEW_MODES) ? UI_viewMode : cfgSaved.viewMode;
+	
+	cfg->crc = Crc(cfg, sizeof(*cfg));
+}
+
+// apply settings to all modules, invalid fields are replaced by defaults
+static void Apply(const CFG_Data_t *cfg)
+{
+	UI_alarmLevel = (cfg->alarmLevel >= 0.0f) ? cfg->alarmLevel : cfgDefaults.alarmLevel; // false for NaN
+	RAD_filterFactor = cfg->filterFactor;
+	RAD_uartLogInterval = cfg->logInterval;
+	RAD_deadTimeModel = (cfg->deadTimeModel < RAD_DT_MODEL_NUM) ? cfg->deadTimeModel : cfgDefaults.deadTimeModel;
+	UI_viewMode = (cfg->viewMode < UI_NUM_VIEW_MODES) ? cfg->viewMode : cfgDefaults.viewMode;
+	UI_clickEnable = (bool)cfg->clickEnable;
+	RAD_uartLogBinary = (bool)cfg->logBinary;
+	GPIO_SetPin(PIN_CLICK_EN, UI_clickEnable);
+}
+
+// convert fields of older config versions, fields that were missing already hold their defaults
+// version 1 is the first layout, nothing to convert yet
+// if the meaning of a field changes, add one step per version: if (cfg->version < 2) { convert v1 -> v2 }
+static void Migrate(CFG_Data_t *cfg)
+{
+	cfg->version = CFG_VERSION;
+}
+
+// CRC-CCITT of the first size bytes after the CRC field
+static uint16_t Crc(const CFG_Data_t *cfg, byte size)
+{
+	const byte *data = (const byte*)cfg;
+	uint16_t crc = 0xFFFF;
+	for (byte i=offsetof(CFG_Data_t, version); i<size; i++) { crc = _crc_ccitt_update(crc, data[i]); }
+	return crc;
+}
+
+// -------------------------------------- EOF --------------------------------------
@@ -11,10 +11,14 @@
 #include "cmd.h"
 //---------------
 #include "adc.h"
+#include "cfg.h"
+#include "eep.h"
+#include "fmt.h"
 #include "gpio.h"
 #include "keys.h"
 #include "pwr.h"
 #include "rad.h"
+#include "rng.h"
 #include "rtc.h"
 #include "sys.h"
 #include "uart.h"
@@ -33,8 +37,8 @@ typedef enum
 } CMD_Reply_t;
 
 // define help text
-// unused letters: gijopqwy
-#define NUM_HELP_STRS	20u
+// unused letters: -
+#define NUM_HELP_STRS	28u
 #define HELP_STR_LEN	24u
 // note: format specifier %S (uppercase!) must be used to printf strings from flash
 static const __flash char helpStr[NUM_HELP_STRS][HELP_STR_LEN] =
@@ -47,18 +51,26 @@ static const __flash char helpStr[NUM_HELP_STRS][HELP_STR_LEN] =
 	"c - clicker setting",
 	"d - dose total",
 	"e - EEPROM r/w @ X",
-	"f - filter factor",
+	"f - filter, 0=adaptive",
+	"g - config, 0=defaults",
 	"h - high voltage",
+	"i - interval histogram",
+	"j - DRBG bytes, binary",
 	"k - key debugging",
 	"l - logging interval",
 	"m - mode view",
-	"n - number random",
+	"n - random, 1=bulk",
+	"o - output binary log",
+	"p - pulse capture, 2=tx",
+	"q - dead time, 0=cal",
 	"r - rate dose",
 	"s - shutdown",
 	"t - time",
 	"u - UART calibration",
 	"v - voltage measure",
+	"w - window averages",
 	"x - EEPROM address",
+	"y - dead-time model",
 	"z - reset system",
 };
 
@@ -74,6 +86,7 @@ void CMD_Parse(char* str)
 	CMD_Reply_t reply = REPLY_OK;
 	int16_t arg_int;
 	float arg_float;
+	char num[FMT_BUF_SIZE];	// formatted fixed-point values
 	bool set = false;
 	static byte x;
 
@@ -98,7 +111,11 @@ void CMD_Parse(char* str)
 		case 'a':
 		{
 			if (set) { UI_alarmLevel = arg_float; }
-			else { UART_Printf("%.3f\n", (double)UI_alarmLevel); }
+			else
+			{
+				FMT_FixedSigned(num, (int32_t)floorf(UI_alarmLevel*1000.0f + 0.5f), 3, 3);
+				UART_Printf("%s\n", num);
+			}
 			
 			break;
 		}
@@ -131,8 +148,12 @@ void CMD_Parse(char* str)
 		// ---------- total dose ----------
 		case 'd':
 		{
-			if (set) { RAD_SetTotalDose(arg_float); }
-			else { UART_Printf("%.4fuSv\n", (double)RAD_GetTotalDose()); }
+			if (set) { RAD_SetTotalDose((uint32_t)(arg_float*1000.0f)); }
+			else
+			{
+				FMT_Fixed(num, RAD_GetTotalDose(), 3, 4);
+				UART_Printf("%suSv\n", num);
+			}
 			
 			break;
 		}
@@ -141,17 +162,17 @@ void CMD_Parse(char* str)
 		case 'e':
 		{
 			// use test variable x as address
-			unsigned addr = x; // dirty hack to silence compiler warning
-			
-			while (!eeprom_is_ready());
 			if (set)
 			{
+				byte data = arg_int;
 				if ((arg_int>0xff) || (arg_int<0)) { reply = REPLY_ERROR; }
-				else { eeprom_update_byte((uint8_t*)addr, (uint8_t)arg_int); }
+				else { EEP_Write(x, &data, sizeof(data)); }
 			}
 			else
 			{
-				UART_Printf("EEP[0x%02X]=0x%02X\n", x, eeprom_read_byte((uint8_t*)addr));
+				byte data;
+				EEP_Read(x, &data, sizeof(data));
+				UART_Printf("EEP[0x%02X]=0x%02X\n", x, data);
 			}
 			
 			break;
@@ -160,8 +181,35 @@ void CMD_Parse(char* str)
 		// ---------- filter factor ----------
 		case 'f':
 		{
-			if (set) { RAD_filterFactor = arg_float; }
-			else { UART_Printf("%.3f\n", (double)RAD_filterFactor); }
+			if (set)
+			{
+				if ((arg_float<0.0f) || (arg_float>1.0f)) { reply = REPLY_ERROR; } // 0 = adaptive
+				else { RAD_filterFactor = (uint16_t)(arg_float*65535.0f); }
+			}
+			else
+			{
+				FMT_Fixed(num, (RAD_filterFactor*1000ul + 32768ul) >> 16, 3, 3);
+				UART_Printf("%s\n", num);
+			}
+			
+			break;
+		}
+		
+		// ---------- persistent config ----------
+		case 'g':
+		{
+			if (set)
+			{
+				// 0 restores defaults, 1 saves immediately
+				if (arg_int == 0) { CFG_Reset(); }
+				else if (arg_int == 1) { CFG_Save(); }
+				else { reply = REPLY_ERROR; }
+			}
+			else
+			{
+				static const __flash char state_names[][9] = {"saved", "pending", "defaults"};
+				UART_Printf("v%u %S\n", CFG_GetVersion(), state_names[CFG_GetState()]);
+			}
 			
 			break;
 		}
@@ -175,9 +223,56 @@ void CMD_Parse(char* str)
 			}
 			else
 			{
-				uint16_t count;
-				RAD_CheckHv(&count);
-				UART_Printf("%u\n", count);
+				// edges per second of the last check & long-term statistics, start a new check in the background
+				RAD_HvStats_t hv = RAD_GetHvStats();
+				FMT_FixedQ(num, hv.ewma, RAD_HV_STATS_Q, 1);
+				UART_Printf("%u min=%u max=%u avg=%s ", RAD_GetHvCounts(), hv.min, hv.max, num);
+				FMT_FixedQ(num, hv.drift, RAD_HV_STATS_Q, 1);
+				UART_Printf("drift=%s/d n=%u%s\n", num, hv.samples, hv.warning?" WARNING":"");
+				RAD_RequestHvCheck();
+			}
+			
+			break;
+		}
+		
+		// ---------- pulse interval histogram ----------
+		case 'i':
+		{
+			if (set)
+			{
+				if (arg_int) { reply = REPLY_ERROR; }
+				else { RAD_ResetIntervalHist(); }
+			}
+			else
+			{
+				// lower bin bound & count of every non-empty bin, filled while pulse capture is enabled
+				// bins are read one by one, no snapshot on the stack; counts may grow while the list is sent
+				for (byte i=0; i<RAD_IHIST_NUM; i++)
+				{
+					uint16_t count = RAD_GetIntervalHist(i);
+					if (!count) { continue; }
+					UART_Printf("%9luus %u\n", RAD_GetIntervalHistBin(i), count);
+					while (UART_TxBusy()); // avoid TX buffer overflow
+				}
+			}
+			
+			break;
+		}
+		
+		// ---------- DRBG output ----------
+		case 'j':
+		{
+			// N bytes in frames of type 0x04, see tools/binlog_decode.py; 0 cancels
+			// DRBG seeds itself from pulse capture while on USB power, denied until the first seed (~4h at background)
+			if (set)
+			{
+				if (arg_int < 0) { reply = REPLY_ERROR; }
+				else if (!RNG_Request(arg_int)) { reply = REPLY_DENIED; } // not seeded yet
+			}
+			else
+			{
+				RNG_Stats_t stats = RNG_GetStats();
+				UART_Printf("seeded=%u pool=%u reseeds=%u age=%lus pending=%u\n", stats.seeded, stats.pool, stats.reseeds, stats.reseedAge, stats.pending);
 			}
 			
 			break;
@@ -213,17 +308,91 @@ void CMD_Parse(char* str)
 		// ---------- random number mode ----------
 		case 'n':
 		{
-			if (set) { reply = REPLY_DENIED; }
-			else { UART_Printf("%u\n", rand()); } // srand is called at random intervals in main
+			// DRBG output once seeded, raw pool before
+			// 1=bulk hex output of GM tube entropy, get shows throughput while active or if nothing is available
+			uint16_t number;
+			if (set)
+			{
+				if ((arg_int < 0) || (arg_int > 1)) { reply = REPLY_ERROR; }
+				else { RNG_SetBulk(arg_int); }
+			}
+			else if (!RNG_GetBulk() && (RNG_GetDrbgBytes(&number, sizeof(number)) || RNG_GetBytes(&number, sizeof(number))))
+			{
+				UART_Printf("%u\n", number);
+			}
+			else
+			{
+				RNG_Stats_t stats = RNG_GetStats();
+				uint32_t secs = stats.time ? stats.time : 1;
+				uint16_t frac = (stats.bits % secs)*100u / secs;
+				UART_Printf("%lu.%02ubit/s out=%lu raw=%lu fail=%u pool=%u ready=%u\n", stats.bits/secs, frac,
+					stats.bits, stats.rawBits, stats.failures, stats.pool, stats.ready);
+			}
+			
+			break;
+		}
+			
+		// ---------- log output format ----------
+		case 'o':
+		{
+			// 0=ASCII, 1=COBS framed binary records, see tools/binlog_decode.py
+			if (set) { RAD_uartLogBinary = (bool)arg_int; }
+			else { UART_Printf("%u\n", RAD_uartLogBinary); }
+			
+			break;
+		}
+		
+		// ---------- pulse capture ----------
+		case 'p':
+		{
+			// 0=off, 1=capture, 2=capture & stream timestamps in binary frames
+			if (set)
+			{
+				if ((arg_int < 0) || (arg_int > 2)) { reply = REPLY_ERROR; }
+				else
+				{
+					RAD_SetCapture(RAD_CAP_USER, arg_int);
+					RAD_SetPulseStream(arg_int == 2);
+				}
+			}
+			else
+			{
+				RAD_PulseStats_t stats = RAD_GetPulseStats();
+				UART_Printf("n=%lu drop=%u link=%u min=%luus last=%luus\n", stats.count, stats.drops, stats.linkDrops, stats.minInterval, stats.lastInterval);
+			}
 			
 			break;
 		}
 			
+		// ---------- dead time ----------
+		case 'q':
+		{
+			if (set)
+			{
+				// 0 starts calibration, otherwise dead time in us
+				if (!arg_int) { RAD_StartDeadTimeCal(); }
+				else if ((arg_int < 0) || !RAD_SetDeadTime(arg_int)) { reply = REPLY_ERROR; }
+			}
+			else
+			{
+				uint32_t samples;
+				UART_Printf("%uus", RAD_GetDeadTime());
+				if (RAD_GetDeadTimeCal(&samples)) { UART_Printf(" cal n=%lu", samples); }
+				UART_Printf("\n");
+			}
+			
+			break;
+		}
+		
 		// ---------- dose rate ----------
 		case 'r':
 		{
 			if (set) { reply = REPLY_DENIED; }
-			else { UART_Printf("%.3fuSv/h\n", (double)RAD_GetDoseRate()); }
+			else
+			{
+				FMT_Fixed(num, RAD_GetDoseRate(), 3, 3);
+				UART_Printf("%suSv/h +-%u%%%s\n", num, RAD_GetDoseRateErr(), RAD_GetOverRange() ? " OVER RANGE" : "");
+			}
 			
 			break;
 		}
@@ -315,6 +484,29 @@ void CMD_Parse(char* str)
 			break;
 		}
 		
+		// ---------- window averages ----------
+		case 'w':
+		{
+			if (set) { reply = REPLY_DENIED; }
+			else
+			{
+				// 10s, 1min, 10min, 1h boxcar averages
+				for (byte i=0; i<RAD_AVG_NUM; i++)
+				{
+					uint32_t avg;
+					if (RAD_GetAvgDoseRate(i, &avg))
+					{
+						FMT_Fixed(num, avg, 3, 3);
+						UART_Printf("%s ", num);
+					}
+					else { UART_Printf("- "); }
+				}
+				UART_Printf("uSv/h\n");
+			}
+			
+			break;
+		}
+		
 		// ---------- EEPROM address / test variable ----------
 		case 'x':
 		{
@@ -331,6 +523,20 @@ void CMD_Parse(char* str)
 			break;
 		}
 
+		// ---------- dead-time model ----------
+		case 'y':
+		{
+			if (set)
+			{
+				// 0=non-paralyzable, 1=paralyzable, 2=hybrid
+				if ((arg_int<0) || (arg_int>=RAD_DT_MODEL_NUM)) { reply = REPLY_ERROR; }
+				else { RAD_deadTimeModel = arg_int; }
+			}
+			else { UART_Printf("%u\n", RAD_deadTimeModel); }
+			
+			break;
+		}
+
 		// ---------- reset ----------
 		case 'z':
 		{
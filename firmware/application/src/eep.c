@@ -0,0 +1,96 @@
+/*
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Implementation of interrupt driven EEPROM access
+===============================================================================
+*/
+
+#include "eep.h"
+
+// internal defines
+#define EEP_QUEUE_SIZE	16u		// pending byte writes, must be a power of 2; holds a dose checkpoint, a config block waits for one byte (~3.4ms)
+
+// pending byte write
+typedef struct
+{
+	uint16_t addr;
+	byte data;
+} EEP_Entry_t;
+
+// internal variables
+// single producer (main loop) / single consumer (EE_READY ISR) ring buffer
+static volatile EEP_Entry_t eepQueue[EEP_QUEUE_SIZE];
+static volatile byte eepQueueIn, eepQueueOut;
+
+// queue bytes for writing, returns immediately unless the queue is full
+// each changed byte takes ~3.4ms, unchanged bytes are skipped to save write cycles
+void EEP_Write(uint16_t addr, const void *data, byte len)
+{
+	const byte *src = data;
+	
+	for (byte i=0; i<len; i++)
+	{
+		// wait for a free slot, ISR keeps draining the queue
+		byte next = (eepQueueIn + 1) & (EEP_QUEUE_SIZE - 1);
+		while (next == eepQueueOut);
+		
+		// slot is not touched by ISR until index is advanced
+		eepQueue[eepQueueIn].addr = addr + i;
+		eepQueue[eepQueueIn].data = src[i];
+		eepQueueIn = next;
+		
+		// EE_READY fires as long as no write is in progress
+		SET(EECR, EERIE);
+	}
+}
+
+// read bytes, pending writes are finished first so data is always up to date
+void EEP_Read(uint16_t addr, void *data, byte len)
+{
+	EEP_Flush();
+	eeprom_read_block(data, (const void*)addr, len);
+}
+
+// wait until all queued bytes are written, needs global interrupts enabled
+// call this before power off or reset
+void EEP_Flush(void)
+{
+	while (EEP_Busy());
+	while (!eeprom_is_ready());
+}
+
+// returns true while writes are pending, EE_READY can't wake up the CPU from power save mode
+bool EEP_Busy(void)
+{
+	return GET(EECR, EERIE);
+}
+
+// EEPROM ready ISR, writes next queued byte that differs from EEPROM content
+ISR(EE_READY_vect)
+{
+	while (eepQueueOut != eepQueueIn)
+	{
+		uint16_t addr = eepQueue[eepQueueOut].addr;
+		byte data = eepQueue[eepQueueOut].data;
+		eepQueueOut = (eepQueueOut + 1) & (EEP_QUEUE_SIZE - 1);
+		
+		// read current content
+		EEAR = addr;
+		SET(EECR, EERE);
+		if (EEDR == data) { continue; }
+		
+		// erase & write, EEPE must be set within 4 cycles after EEMPE
+		EEDR = data;
+		EECR = BV(EERIE)|BV(EEMPE);
+		SET(EECR, EEPE);
+		return;
+	}
+	
+	// queue empty
+	CLR(EECR, EERIE);
+}
+
+// -------------------------------------- EOF --------------------------------------
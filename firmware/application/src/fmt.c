@@ -0,0 +1,131 @@
+/*
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Implementation of fixed-point number formatting
+===============================================================================
+*/
+
+#include "fmt.h"
+
+// internal defines
+#define FMT_DIGITS_MAX	10u		// decimal digits of uint32_t
+
+// internal variables
+static const __flash uint32_t fmtPow10[FMT_DIGITS_MAX] =
+{
+	1ul, 10ul, 100ul, 1000ul, 10000ul, 100000ul, 1000000ul, 10000000ul, 100000000ul, 1000000000ul
+};
+
+// internal function prototypes
+static byte AutoRange(char *buf, uint32_t dose);
+
+// format value with 'scale' implied decimals (e.g. nSv with scale 3 -> uSv), rounded to 'decimals' decimals
+// digits are found by subtracting powers of ten, no division -> ~1000 cycles for a full 10 digit value
+// returns string length, buf needs FMT_BUF_SIZE bytes
+byte FMT_Fixed(char *buf, uint32_t value, byte scale, byte decimals)
+{
+	// round half up at the last printed digit, dropped digits are skipped below
+	byte cut = (decimals < scale) ? (scale - decimals) : 0;
+	if (cut)
+	{
+		uint32_t half = 5u*fmtPow10[cut - 1];
+		value = (value > (UINT32_MAX - half)) ? UINT32_MAX : (value + half);
+	}
+	
+	char *p = buf;
+	for (int8_t k=FMT_DIGITS_MAX-1; k>=(int8_t)cut; k--)
+	{
+		uint32_t pk = fmtPow10[k];
+		char digit = '0';
+		while (value >= pk)
+		{
+			value -= pk;
+			digit++;
+		}
+		
+		// integer part without leading zeros, units digit is always printed
+		if (k == scale - 1) { *p++ = '.'; }
+		if ((p != buf) || (digit != '0') || (k <= scale)) { *p++ = digit; }
+	}
+	
+	// more decimals than implied by scale
+	for (byte i=scale; i<decimals; i++)
+	{
+		if (!i) { *p++ = '.'; }
+		*p++ = '0';
+	}
+	
+	*p = 0;
+	return p - buf;
+}
+
+// same as FMT_Fixed() for signed values
+byte FMT_FixedSigned(char *buf, int32_t value, byte scale, byte decimals)
+{
+	if (value >= 0) { return FMT_Fixed(buf, value, scale, decimals); }
+	
+	buf[0] = '-';
+	return FMT_Fixed(&buf[1], -(uint32_t)value, scale, decimals) + 1;
+}
+
+// binary fixed-point value with 'frac_bits' fractional bits (>0), rounded to 'decimals' decimals
+// value*10^decimals must fit into int32_t
+byte FMT_FixedQ(char *buf, int32_t value, byte frac_bits, byte decimals)
+{
+	int32_t scaled = (value*(int32_t)fmtPow10[decimals] + (1l << (frac_bits - 1))) >> frac_bits; // floors -> rounds half up
+	return FMT_FixedSigned(buf, scaled, decimals, decimals);
+}
+
+// total dose in nSv, auto-ranging like the dose rate
+byte FMT_Dose(char *buf, uint32_t dose)
+{
+	return AutoRange(buf, dose);
+}
+
+// dose rate in nSv/h, auto-ranging: 3 significant digits or more, uSv/h up to 1000
+byte FMT_DoseRate(char *buf, uint32_t rate)
+{
+	byte len = AutoRange(buf, rate);
+	buf[len++] = '/';
+	buf[len++] = 'h';
+	buf[len] = 0;
+	return len;
+}
+
+// time of day as hh:mm:ss
+byte FMT_Time(char *buf, byte hours, byte mins, byte secs)
+{
+	byte values[3] = {hours, mins, secs};
+	char *p = buf;
+	
+	for (byte i=0; i<3; i++)
+	{
+		if (i) { *p++ = ':'; }
+		*p++ = '0' + values[i]/10u;
+		*p++ = '0' + values[i]%10u;
+	}
+	
+	*p = 0;
+	return p - buf;
+}
+
+// nSv -> x.xxxuSv, xx.xxuSv, xxx.xuSv or x.xxmSv
+static byte AutoRange(char *buf, uint32_t dose)
+{
+	byte len;
+	if (dose < 10000ul)			{ len = FMT_Fixed(buf, dose, 3, 3); }
+	else if (dose < 100000ul)	{ len = FMT_Fixed(buf, dose, 3, 2); }
+	else if (dose < 1000000ul)	{ len = FMT_Fixed(buf, dose, 3, 1); }
+	else						{ len = FMT_Fixed(buf, dose, 6, 2); }
+	
+	buf[len++] = (dose < 1000000ul) ? 'u' : 'm';
+	buf[len++] = 'S';
+	buf[len++] = 'v';
+	buf[len] = 0;
+	return len;
+}
+
+// -------------------------------------- EOF --------------------------------------
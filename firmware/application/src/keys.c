@@ -101,6 +101,7 @@ static void HandleKeys(void)
 
 	// process valid key release events
 	keyEvent |= keys_released;
+	SYS_SET_EVENT(SYS_EVT_KEYS);
 }
 
 // merge individual key states to a key vector byte, invert logic polarity
@@ -133,6 +134,7 @@ ISR(TIMER2_COMPA_vect)
 	// if the key that was pressed is still being held down -> long key press
 	byte keys_still_pressed = keysPressed & GetKeys();
 	keyEvent |= (keys_still_pressed << KEY_LONG_SHIFT);
+	if (keys_still_pressed) { SYS_SET_EVENT(SYS_EVT_KEYS); }
 	StopTimeout();
 }
 
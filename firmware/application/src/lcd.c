@@ -19,7 +19,12 @@
 #define LCD_COLUMNS			16u
 #define LCD_INIT_LEN		8u
 #define LCD_CONTRAST		35u
+#define LCD_SPI_HW			1	// 1=SPI0 & Timer0 paced queue, CPU sleeps during execution times; 0=bit-banged & busy waiting
 #define LCD_SPI_DELAY		30u // data commands need 26us
+#define LCD_CLEAR_DELAY		1080u // [us]; clear display & return home according to datasheet
+#define LCD_QUEUE_SIZE		64u	// pending bytes, must be a power of 2; holds a worst case flush of 32 cells & 32 positions
+#define LCD_T0_TICK			8u	// [us]; Timer0 clock with prescaler 64
+#define LCD_T0_TOP(us)		(((us) + LCD_T0_TICK - 1u)/LCD_T0_TICK - 1u) // Timer0 compare value for a delay
 
 // pin mapping
 #define LCD_PIN_CS		PIN_LCD_CS
@@ -30,7 +35,19 @@
 // internal variables
 static const uint8_t init_DOGM162_5V[LCD_INIT_LEN] = {0x39, 0x1C, 0x52, 0x69, 0x74, 0x38, 0x01, 0x06};
 static uint8_t cmdByte;
-static byte currentLine;
+
+// print functions only write the frame buffer, LCD_Flush() sends the cells that differ from the shadow buffer
+static byte lcdFrame[LCD_LINES][LCD_COLUMNS];	// content to be displayed
+static byte lcdShadow[LCD_LINES][LCD_COLUMNS];	// content of the display RAM
+static byte frameLine, frameColumn;				// print position in frame buffer, 0-based
+
+#if LCD_SPI_HW
+// single producer (main loop) / single consumer (TIMER0_COMPA ISR) ring buffer
+// RS is kept as one bit per slot, ISR derives the execution time from it & the command byte
+static volatile byte lcdQueue[LCD_QUEUE_SIZE];
+static volatile byte lcdQueueRs[LCD_QUEUE_SIZE/8u];	// bit set marks a data byte (RS high)
+static volatile byte lcdQueueIn, lcdQueueOut;
+#endif
 
 // max of 8 custom chars can be defined here
 // BASCOM-AVR was used to determine these values
@@ -47,9 +64,14 @@ static const __flash uint8_t lcdCustomChars[LCD_NUM_SYMBOLS][8]=
 };
 
 // internal function prototypes
+#if !LCD_SPI_HW
 static void SpiOut(uint8_t dat);
+#endif
 static void SpiInit(void);
-static void SpiPutChar(uint8_t dat);
+static void SpiPutChar(uint8_t dat, bool rs);
+#if LCD_SPI_HW
+static byte CommandTop(uint8_t cmd);
+#endif
 static void CursorEn(bool on);
 static void SendCommand(uint8_t dat);
 static void SendData(uint8_t dat);
@@ -86,27 +108,29 @@ void LCD_Init(void)
 		}
 	}
 	
-	// clear & reset position
+	// clear display & buffers, reset position
+	SendCommand(0x01);
+	memset(lcdShadow, ' ', sizeof(lcdShadow));
 	LCD_Clear();
 	CursorEn(false);
 	SetContrast(LCD_CONTRAST);
 	LCD_Enable(true);
 }
 
-// wrapper for printf
+// wrapper for printf, chars beyond the last column are dropped
 int LcdPutChar(char c, FILE *stream)
 {
 	(void)stream;
-	SendData(c);
+	if (frameColumn < LCD_COLUMNS) { lcdFrame[frameLine][frameColumn++] = c; }
 	return 0;
 }
 
 /*----------------------------
 Func: String
-Desc: Shows a String on the DOG-Display
-Vars: String
+Desc: Prints a String to the frame buffer, line 0 continues at the current position
+Vars: String, format string in flash, use LCD_Printf() for literals
 ------------------------------*/
-void LCD_Printf(uint8_t line, const char *formatstr, ...)
+void LCD_PrintfP(uint8_t line, const char *formatstr, ...)
 {
 	// select line
 	if (line) { LCD_Position(line, 0); }
@@ -115,36 +139,72 @@ void LCD_Printf(uint8_t line, const char *formatstr, ...)
 	va_list args;
 	va_start(args, formatstr);
 	static FILE lcd_stream = FDEV_SETUP_STREAM(LcdPutChar, NULL, _FDEV_SETUP_WRITE);
-	vfprintf(&lcd_stream, formatstr, args);
+	vfprintf_P(&lcd_stream, formatstr, args);
 	va_end(args);
 }
 
+/*----------------------------
+Func: string
+Desc: Prints a String to the frame buffer without printf, line 0 continues at the current position
+Vars: String
+------------------------------*/
+void LCD_PrintStr(uint8_t line, const char *str)
+{
+	if (line) { LCD_Position(line, 0); }
+	while (*str) { LcdPutChar(*str++, NULL); }
+}
+
 /*----------------------------
 Func: ascii
-Desc: Shows a Character on the DOG-Display
+Desc: Prints a Character to the frame buffer
 Vars: Character
 ------------------------------*/
 void LCD_PrintChar(uint8_t line, uint8_t column, char character)
 {
 	LCD_Position(line, column);
-	SendData(character);
+	LcdPutChar(character, NULL);
 }
 
 /*----------------------------
 Func: position
-Desc: Sets a new cursor position DOG-Display
-Vars: column (1..16), line (1..3)
+Desc: Sets a new print position in the frame buffer
+Vars: column (1..16), line (1..2)
 ------------------------------*/
 void LCD_Position(uint8_t line, uint8_t column)
 {
-	uint8_t cmd = 0;
 	if (column == 0) { column = 1; }		// minimum column 1
-	if (column > 16) { column = 16; }	// maximum column 16
+	if (column > LCD_COLUMNS) { column = LCD_COLUMNS; }	// maximum column 16
 	
-	// 2-Line display second line address
-	if (line == 2) { cmd = 0x40; }
+	frameLine = (line == 2) ? 1 : 0;
+	frameColumn = column - 1; // DOG display starts with column 0 --> decrement
+}
+
+/*----------------------------
+Func: flush
+Desc: Sends changed cells of the frame buffer to the DOG-Display
+	  cursor is only set if the changed cell doesn't follow the previous one, ~40us per byte
+Vars: ---
+------------------------------*/
+void LCD_Flush(void)
+{
+	byte addr = 0xFF; // display RAM address of the cursor, unknown at start
 	
-	SendCommand(0x80 + cmd + column - 1); // DOG display starts with column 0 --> decrement
+	for (byte line=0; line<LCD_LINES; line++)
+	{
+		for (byte column=0; column<LCD_COLUMNS; column++)
+		{
+			byte c = lcdFrame[line][column];
+			if (c == lcdShadow[line][column]) { continue; }
+			
+			// 2-Line display second line address
+			byte cell = (line ? 0x40 : 0x00) + column;
+			if (cell != addr) { SendCommand(0x80 + cell); }
+			
+			SendData(c);
+			lcdShadow[line][column] = c;
+			addr = cell + 1; // address auto increment
+		}
+	}
 }
 
 /*----------------------------
@@ -160,15 +220,30 @@ void LCD_Enable(bool on)
 	SendCommand(cmdByte);
 }
 
+/*----------------------------
+Func: busy
+Desc: Returns true while queued bytes are sent, Timer0 needs the I/O clock -> idle sleep only
+Vars: ---
+------------------------------*/
+bool LCD_Busy(void)
+{
+#if LCD_SPI_HW
+	return (TCCR0B != 0);
+#else
+	return false;
+#endif
+}
+
 /*----------------------------
 Func: clear_display
-Desc: clears the entire DOG-Display
+Desc: clears the frame buffer & returns home, no slow clear command needed
 Vars: ---
 ------------------------------*/
 void LCD_Clear(void) 
 {
-	SendCommand(0x01); // clear display and return home
-	currentLine = 1;
+	memset(lcdFrame, ' ', sizeof(lcdFrame));
+	frameLine = 0;
+	frameColumn = 0;
 }
 
 /*----------------------------
@@ -211,12 +286,7 @@ Vars: data
 ------------------------------*/
 static void SendCommand(uint8_t dat) 
 {
-	GPIO_SetPin(LCD_PIN_RST, LO);
-	SpiPutChar(dat);
-
-	// extra delay for return home or clear display cmds
-	// 1.08ms according to datasheet 
-	if (dat <= 0x03) { _delay_us(1080); }
+	SpiPutChar(dat, LO);
 }
 
 /*----------------------------
@@ -226,8 +296,7 @@ Vars: data
 ------------------------------*/
 static void SendData(uint8_t dat) 
 {
-	GPIO_SetPin(LCD_PIN_RST, HI);
-	SpiPutChar(dat);
+	SpiPutChar(dat, HI);
 }
 
 /*----------------------------
@@ -247,21 +316,57 @@ static void SpiInit(void)
 	// Set SPI-Mode 3: CLK idle high, rising edge, MSB first
 	GPIO_ConfigPin(LCD_PIN_CLK, OUT);
 	GPIO_SetPin(LCD_PIN_CLK, HI);
+	
+#if LCD_SPI_HW
+	// SPI0 master, mode 3, f_cpu/4 = 2MHz; SS (PB2) is an output -> stays master
+	SPCR0 = BV(SPE)|BV(MSTR)|BV(CPOL)|BV(CPHA);
+	
+	// Timer0 CTC mode, compare interrupt paces the queue, started on demand
+	TCCR0A = BV(WGM01);
+	TIMSK0 = BV(OCIE0A);
+#endif
 }
 
 /*----------------------------
 Func: SpiPutChar
-Desc: Sends one uint8_t using CS
-Vars: data
+Desc: Sends one uint8_t using CS & waits for its execution time
+	  hardware SPI: queued, returns immediately unless the queue is full
+Vars: data, RS pin state
 ------------------------------*/
-static void SpiPutChar(uint8_t dat) 
+static void SpiPutChar(uint8_t dat, bool rs) 
 {
+#if LCD_SPI_HW
+	// wait for a free slot, ISR keeps draining the queue
+	byte next = (lcdQueueIn + 1) & (LCD_QUEUE_SIZE - 1);
+	while (next == lcdQueueOut);
+	
+	// slot is not touched by ISR until index is advanced, ISR only reads the RS bits
+	byte bit = 1u << (lcdQueueIn & 7u);
+	lcdQueue[lcdQueueIn] = dat;
+	if (rs) { lcdQueueRs[lcdQueueIn >> 3] |= bit; }
+	else { lcdQueueRs[lcdQueueIn >> 3] &= ~bit; }
+	lcdQueueIn = next;
+	
+	// start timer if idle, ISR sends the byte on the next compare match
+	if (!TCCR0B)
+	{
+		TCNT0 = 0;
+		OCR0A = 0;
+		TCCR0B = BV(CS01)|BV(CS00);
+	}
+#else
+	GPIO_SetPin(LCD_PIN_RST, rs);
 	GPIO_SetPin(LCD_PIN_CS, LO);
 	SpiOut(dat);
 	GPIO_SetPin(LCD_PIN_CS, HI);
 	_delay_us(LCD_SPI_DELAY);
+	
+	// extra delay for return home or clear display cmds
+	if (!rs && (dat <= 0x03)) { _delay_us(LCD_CLEAR_DELAY - LCD_SPI_DELAY); }
+#endif
 }
 
+#if !LCD_SPI_HW
 /*----------------------------
 Func: SpiOut
 Desc: Sends one uint8_t, no CS
@@ -278,5 +383,49 @@ static void SpiOut(uint8_t dat)
 		GPIO_SetPin(LCD_PIN_CLK, HI);
 	} while (--i);
 }
+#endif
+
+#if LCD_SPI_HW
+/*----------------------------
+Func: CommandTop
+Desc: Minimum execution time of a command according to the ST7036 datasheet as Timer0 compare value
+Vars: command
+------------------------------*/
+static byte CommandTop(uint8_t cmd)
+{
+	// clear display & return home
+	if (cmd <= 0x03) { return LCD_T0_TOP(LCD_CLEAR_DELAY); }
+	
+	return LCD_T0_TOP(LCD_SPI_DELAY);
+}
+
+// Timer0 compare ISR, sends the next queued byte once the execution time of the previous one has passed
+// transfer takes 4us at 2MHz, well within the shortest period
+ISR(TIMER0_COMPA_vect)
+{
+	GPIO_SetPin(LCD_PIN_CS, HI);
+	
+	// queue empty -> stop timer
+	if (lcdQueueOut == lcdQueueIn)
+	{
+		TCCR0B = 0;
+		return;
+	}
+	
+	byte dat = lcdQueue[lcdQueueOut];
+	bool rs = lcdQueueRs[lcdQueueOut >> 3] & (1u << (lcdQueueOut & 7u));
+	lcdQueueOut = (lcdQueueOut + 1) & (LCD_QUEUE_SIZE - 1);
+	
+	GPIO_SetPin(LCD_PIN_RST, rs);
+	GPIO_SetPin(LCD_PIN_CS, LO);
+	SPDR0 = dat;
+	
+	byte top = rs ? LCD_T0_TOP(LCD_SPI_DELAY) : CommandTop(dat);
+	
+	// ISR may be delayed by others, a compare value behind the counter would only match after wrap around
+	byte min_top = TCNT0 + 2u;
+	OCR0A = (top > min_top) ? top : min_top;
+}
+#endif
 
 // -------------------------------------- EOF --------------------------------------
@@ -9,12 +9,14 @@
 */
 
 #include "adc.h"
+#include "cfg.h"
 #include "cmd.h"
 #include "gpio.h"
 #include "keys.h"
 #include "lcd.h"
 #include "pwr.h"
 #include "rad.h"
+#include "rng.h"
 #include "rtc.h"
 #include "sys.h"
 #include "uart.h"
@@ -35,62 +37,64 @@ int main(void)
 	SYS_Assert(ok);
 
 	// ================ main loop ================
-	// this block will execute after wake-up from any enabled interrupt:
-	// sec tick (TIMER2_OVF), UART (USART0_UDRE, USART0_RX), rad event (INT1/PCINT1), keys (PCINT2/TIMER2_COMPA), USB dis/connect (INT0)
+	// woken up by any enabled interrupt, but only ISRs that set a pending event make the handlers below run:
+	// sec tick (TIMER2_OVF), UART line (USART0_RX), keys (PCINT2/TIMER2_COMPA), USB dis/connect (INT0),
+	// captured pulses & rate alarm (INT1), TX buffer low (USART0_UDRE)
 	while (true)
 	{
-		// handle UART only if enabled
-		if (UART_GetEnabled())
+		byte events = SYS_GetEvents();
+		
+		// try to read string from UART & parse command
+		if ((events & SYS_EVT_UART_RX) && UART_GetEnabled())
 		{
-			// try to read string from UART & parse command
 			char str[UART_RX_BUF_SIZE] = {0};
-			if (UART_RxString(str))
-			{
-				CMD_Parse(str);
-			}
-			else // let random numbers be independent of UART
-			{
-				// seed PRNG sequencer with value of free running T1
-				// T2 overflow is not synchronized to T1, detector interrupts are truly random
-				// note: I/O clock to T1 is halted during sleep, this RNG might not be great..
-				srand((unsigned int)TCNT1);
-			}
+			if (UART_RxString(str)) { CMD_Parse(str); }
 		}
 
-		// flag is set by T2 ISR every second
-		if (RTC_CheckSecTick())
+		// set by T2 ISR every second
+		if (events & SYS_EVT_SEC_TICK)
 		{
 			// reset watchdog (2s timeout)
 			wdt_reset();
 
 			// monitor HV & tube, process radiation data, logging
 			RAD_EngineTick();
+			RNG_Tick();
 		
 			// handle UI
 			UI_CheckAlarm();
 			UI_UpdateBattery();
 			UI_RenderLcd();
+			
+			// save changed settings
+			CFG_Tick();
 		}
 		
+		// rate alarm flag is set by INT1 ISR or sec tick processing
+		if ((events & (SYS_EVT_RATE_ALARM|SYS_EVT_SEC_TICK)) && RAD_CheckRateAlarm()) { UI_RateAlarm(); }
+		
 		// check if key was pressed
-		byte key = KEYS_GetEvents();
-		if (key)
+		if (events & SYS_EVT_KEYS)
 		{
-			UI_HandleKeys(key);
-			UI_RenderLcd();
+			byte key = KEYS_GetEvents();
+			if (key)
+			{
+				UI_HandleKeys(key);
+				UI_RenderLcd();
+			}
 		}
 
-		// check if USB was connected or disconnected
-		if (PWR_CheckUsbEvent())
-		{
-			LCD_Clear();
-			UI_RenderLcd();
-		}
+		// evaluate captured pulse timestamps
+		if (events & SYS_EVT_PULSES) { RAD_ProcessPulses(); }
+		
+		// refill TX buffer with requested random bytes
+		if (events & SYS_EVT_UART_TX) { RNG_ProcessRequest(); }
 
-		// wait until UART is idle before entering sleep mode
-		while (UART_TxBusy());
+		// USB was connected or disconnected
+		if (events & SYS_EVT_USB) { UI_RenderLcd(); }
 		
 		// go to sleep to save power until interrupt wakes us up again
+		// UART transmission continues in idle mode
 		PWR_SleepMode();
 		
 	} // end main loop
@@ -130,12 +134,14 @@ static bool InitSystem(void)
  	LCD_Init();
  	LCD_Printf(1, "OSIRIS");
  	LCD_Printf(2, "HW v%s FW v%s", HW_REV, FW_REV);
+	LCD_Flush();
 	
 	// init Timer2, needed for systick and RTC
 	if (!RTC_InitRtc())
 	{
 		LCD_Clear();
 		LCD_Printf(1, "RTC FAULT !!");
+		LCD_Flush();
 		UART_Printf("RTC FAULT !!");
 		return false;
 	}
@@ -145,10 +151,13 @@ static bool InitSystem(void)
 	{
 		LCD_Clear();
 		LCD_Printf(1, "UART cal..");
+		LCD_Flush();
 		
 		bool ok = UART_Calibrate(true);
 		
-		LCD_Printf(2, ok?"OK!":"ERROR!");
+		if (ok) { LCD_Printf(2, "OK!"); }
+		else { LCD_Printf(2, "ERROR!"); }
+		LCD_Flush();
 		_delay_ms(1000); // keep message visible for a while
 	}
 	
@@ -157,6 +166,7 @@ static bool InitSystem(void)
 	{
 		LCD_Clear();
 		LCD_Printf(1, "ADC FAULT !!");
+		LCD_Flush();
 		UART_Printf("ADC FAULT !!");
 		return false;
 	}
@@ -166,6 +176,7 @@ static bool InitSystem(void)
 	{
 		LCD_Clear();
 		LCD_Printf(1, "HV FAULT !!");
+		LCD_Flush();
 		return false;
 	}
 
@@ -173,8 +184,11 @@ static bool InitSystem(void)
 	KEYS_Init();
 	UI_Init();
 	
-	// start T1 for RNG, prescaler 1
-	SET(TCCR1B, CS10);
+	// restore settings, overrides defaults of the modules above
+	CFG_Init();
+	
+	// start T1 for pulse timestamps, prescaler 8 -> 1us resolution
+	SET(TCCR1B, CS11);
 	
 	UART_Printf("Ready!\n");
 	UART_Printf("Enter '?' for help.\n");
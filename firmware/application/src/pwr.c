@@ -10,6 +10,7 @@
 
 #include "pwr.h"
 //---------------
+#include "eep.h"
 #include "gpio.h"
 #include "keys.h"
 #include "lcd.h"
@@ -25,7 +26,6 @@ typedef enum
 } PWR_Src_t;
 
 // internal variables
-static bool usbChangedFlag;
 static volatile PWR_Src_t pwrSrc;
 
 // init USB connect / disconnect detection
@@ -48,21 +48,12 @@ void PWR_DeInit(void)
 	CLR(EIMSK, INT0);
 }
 
-// this returns true once if USB state changed
-bool PWR_CheckUsbEvent(void)
-{
-	if (usbChangedFlag)
-	{
-		usbChangedFlag = false;
-		return true;
-	}
-	
-	return false;
-}
-
 // force system reset
 void PWR_Reset(void)
 {
+	// finish pending EEPROM writes
+	EEP_Flush();
+	
 	// global interrupt disable
 	cli();
 	
@@ -75,10 +66,20 @@ void PWR_Reset(void)
 }
 
 // go to PowerSave mode, keeps async T2 running
+// idle mode is used instead if the I/O clock is needed for T1 pulse timestamps or UART transmission,
+// or if EEPROM writes are pending, EE_READY can only wake up the CPU from idle mode
+// returns immediately if main loop events are pending, checked with interrupts disabled so no event is missed
 void PWR_SleepMode(void)
 {
 	cli();				// global interrupts disable
-	set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+	if (SYS_pendingEvents)
+	{
+		sei();
+		return;
+	}
+	
+	bool idle = RAD_GetCapture() || UART_TxSleep() || EEP_Busy() || LCD_Busy();
+	set_sleep_mode(idle ? SLEEP_MODE_IDLE : SLEEP_MODE_PWR_SAVE);
 	sleep_enable();		// set SE bit
 	sei();				// global interrupts re-enable
 	sleep_cpu();		// go to power save mode
@@ -96,12 +97,15 @@ void PWR_Shutdown(void)
 	// show shutdown message
 	LCD_Clear();
 	LCD_Printf(1, "Power off..");
+	LCD_Flush();
 	UI_EmitBeep(100);
 	_delay_ms(1000);
 
 	// disable LCD
 	LCD_Clear();
+	LCD_Flush();
 	LCD_Enable(false);
+	while (LCD_Busy());
 
 	// disable beeper & soft-latch
 	GPIO_SetPin(PIN_BEEP_EN, false);
@@ -110,6 +114,7 @@ void PWR_Shutdown(void)
 	
 	// save total accumulated dose to EEPROM
 	RAD_SaveTotalDose();
+	EEP_Flush();
 
 	// disable watchdog
 	wdt_reset();
@@ -134,6 +139,7 @@ void PWR_Shutdown(void)
 		// wait for red key release
 		while (!GPIO_GetPin(PIN_KEY_RED));
 		_delay_ms(100); // debounce, just in case
+		(void)SYS_GetEvents(); // discard pending events, they would prevent sleep
 
 		// go to sleep
 		PWR_SleepMode();
@@ -151,7 +157,7 @@ ISR(INT0_vect)
 	{
 		UART_Enable(usb);	// UART not needed if USB not connected
 		pwrSrc = usb;		// set new power source
-		usbChangedFlag = true;
+		SYS_SET_EVENT(SYS_EVT_USB);
 		return;
 	}
 }
@@ -10,54 +10,305 @@
 
 #include "rad.h"
 //---------------
+#include "eep.h"
+#include "fmt.h"
 #include "gpio.h"
+#include "rng.h"
 #include "rtc.h"
 #include "uart.h"
 
 // internal defines
 #define RAD_DEBUG				0		// 0=off, 1=print longest interval between pulses
-#define RAD_MAX_PULSE_INTERVAL	60u		// [s]; no time >30s was observed between pulses in ~12h, double it just in case
-#define RAD_HV_MIN_PULSES		10u		// typically 25 edges in 100ms at background levels, leave some margin
-#define RAD_HV_MAX_PULSES		500u	// theoretical maximum at full load
+#define RAD_MAX_PULSE_INTERVAL	300u	// [s]; silence limit cap, ln(1/p_fa)/r still fits at the lowest supported background of 0.05CPS (277s)
+#define RAD_SILENCE_LN_Q16		((uint32_t)(13.816f*65536.0f))	// ln(1/p_fa), false alarm probability 1e-6 per silent period
+#define RAD_SILENCE_GAP_LN_Q16	((uint32_t)(4.605f*65536.0f))	// ln(1/0.01), a finished gap caps the rate to one it had 1% chance at
+#define RAD_SILENCE_RATE_SHIFT	6u		// count rate is learned by an EWMA with factor 1/64, noise <10% at 1CPS
+#define RAD_HV_MIN_PULSES		100u	// typically 250 edges per second at background levels, leave some margin
+#define RAD_HV_MAX_PULSES		5000u	// theoretical maximum at full load
+#define RAD_HV_CHECK_INTERVAL	60u		// [s]; periodic HV supply check
+#define RAD_HV_EWMA_SHIFT		4u		// EWMA of HV edge counts with factor 1/16 -> ~16min time constant
+#define RAD_HV_SNAP_NUM			24u		// hourly snapshots of the EWMA, used for drift per day
+#define RAD_HV_SNAP_MIN			3u		// minimum number of snapshots for drift estimation
+#define RAD_HV_DRIFT_WARN_PCT	20u		// [%/d]; early warning if load drifts faster
+#define RAD_HV_DEV_WARN_PCT		50u		// [%]; early warning if a sample deviates more from EWMA
+#define RAD_PULSE_BUF_SIZE		32u		// timestamp ring buffer, must be a power of 2, 6.4ms of slack at 5kCPS
+#define RAD_IHIST_BIN_MIN		10u		// half-octave index of the first regular histogram bin (32us)
 
-// SBM20: 190us dead time, incl. amp: 210uS -> 60s/200us=300kHz, avoid div/0 by choosing lower value
-#define RAD_DEAD_TIME		190e-6f
+// SBM20: 190us dead time, incl. amp: 210uS
+// default if no calibrated value is stored in EEPROM
+#define RAD_DEAD_TIME_US	190ul
+#define RAD_DEAD_TIME_Q24(us)	(((us)*2097152ul + 62500ul)/125000ul) // dead time in 2^-24 s units
+#define RAD_DEAD_TIME_MIN_US	50u		// plausible range of calibrated dead time
+#define RAD_DEAD_TIME_MAX_US	500u
+#define RAD_DT_LUT_SIZE		65u		// entries per dead-time model, see deadTimeLut
+#define RAD_DT_HYBRID_A		0.5f	// paralyzable fraction of the hybrid model
+#define RAD_DT_FACTOR_MAX	65535u	// Q12; ~16x, non-paralyzable 1/(1-m*t) is computed beyond the table up to this factor
+#define RAD_OVER_RANGE_HOLD	10u		// [s]; over-range flag is held after the last second beyond the correction range
+
+// dead-time calibration: non-paralyzable intervals are t + Exp(1/n) -> t = mean - sd, standard error is sd/sqrt(N)
+// needs ~1kCPS for a 5us error within a minute, at ~200CPS it takes over an hour
+#define RAD_DTCAL_MAX_ERR_US	5u		// [us]; calibration finishes once standard error is below
+#define RAD_DTCAL_MIN_NUM		4096ul	// minimum number of intervals
+#define RAD_DTCAL_MAX_NUM		(1ul << 20) // calibration fails if still not precise enough
+#define RAD_DTCAL_CHECK_MASK	0x3FFu	// precision is checked every 1024 intervals
+
+// total dose journal: ring of sequence numbered, CRC protected checkpoints in the upper 768 bytes of EEPROM
+// one slot every 5min -> every cell is written every 8h, 100k write cycles last >90 years
+#define RAD_JOURNAL_START		0x100u
+#define RAD_JOURNAL_SIZE		0x300u
+#define RAD_JOURNAL_SLOT_NUM	(RAD_JOURNAL_SIZE/sizeof(RAD_JournalSlot_t))
+#define RAD_JOURNAL_INTERVAL	300u	// [s]; checkpoints are only written if dose changed
+
+// binary log: COBS frames with a key record every 16 records or after a dropped frame, delta records otherwise
+#define RAD_LOG_KEY				0x01u	// uptime u32, counts u32, rate u32, dose u32; little endian
+#define RAD_LOG_DELTA			0x02u	// varints: uptime delta, counts, zigzag rate delta, dose delta
+#define RAD_LOG_KEY_INTERVAL	16u
+#define RAD_LOG_PULSES			0x03u	// capture drops u16, link drops u16, first timestamp u32 [us], varint intervals
+#define RAD_LOG_PULSES_HEAD		9u		// header size of pulse frames
 
 // conversion factor CPM -> uSv/h, for SBM-20 GM tube
 // 175 is widely used in amateur projects, 220 matches official background radiation data, 210 seems to be valid for Cs-137
-#define RAD_CONV_FACTOR		215.0f
+#define RAD_CONV_FACTOR		215ul
+#define RAD_COUNTS_PER_USV	(60ul*RAD_CONV_FACTOR)
+#define RAD_DOSE_DIV_Q8		(RAD_COUNTS_PER_USV*256ul/10u) // Q8 counts per 100nSv
+#define RAD_RATE_SCALE_Q15	((60000ul*32768ul + RAD_CONV_FACTOR*128ul)/(RAD_CONV_FACTOR*256ul)) // Q8 CPS -> nSv/h in Q15, needs factor >118
+#define RAD_RATE_MAX_Q8		0xFFFFFFul	// upper limit of corrected Q8 CPS value, keeps Q16 multiplications in 32bit
+#define RAD_RATE_ERR_MAX	99u			// [%]; upper limit of displayed dose rate uncertainty
+
+// adaptive filter: CUSUM tests for a doubling / halving of the rate, decision threshold in Q16 nats
+// 8 nats -> ~1 false reset per hour at 4CPS, a tenfold rate increase is detected within ~2s at background levels
+#define RAD_ADAPT_THRESHOLD	(8ul << 16)
+#define RAD_ADAPT_MAX_WINDOW	300u	// [s]; averaging window length limit of stable rates
+#define RAD_LN2_Q16			45426u
+
+// rate alarm: raw counts in windows of 1/4, 1, 4 & 16s are compared to a Poisson limit derived from the alarm level
+// 1/4s windows are evaluated in INT1 ISR, based on TCNT2 (3.9ms ticks) -> 64 ticks per window
+#define RAD_ALARM_WIN_NUM	4u
+#define RAD_ALARM_WIN_SHIFT	6u		// TCNT2 >> 6 = quarter second index
+#define RAD_ALARM_WIN_NONE	0xFFu	// invalid window index, forces restart of the quarter second count
+#define RAD_ALARM_P_FA		1.0e-6f	// false alarm probability per window evaluation at the alarm level
+#define RAD_ALARM_Z_FA		4.753f	// standard normal quantile of RAD_ALARM_P_FA
+
+// count history: per second ring with running sums, 30s & 1min block sums for the longer windows
+#define RAD_HIST_SIZE		60u		// [s]; per second raw counts
+#define RAD_BLOCK_NUM_30S	20u		// 30s block sums -> 10min window
+#define RAD_BLOCK_NUM_1MIN	60u		// 1min block sums -> 1h window
+#define RAD_BLOCK_ESC		0x8000u	// block sums >= this are stored as RAD_BLOCK_ESC | (sum >> RAD_BLOCK_ESC_SHIFT)
+#define RAD_BLOCK_ESC_SHIFT	7u		// max. sum 65535*60, resolution 0.4% of escaped values
+#define RAD_SUM_NUM			5u		// running sums over the per second ring
+#define RAD_SUM_4S			0u
+#define RAD_SUM_10S			1u
+#define RAD_SUM_16S			2u
+#define RAD_SUM_30S			3u
+#define RAD_SUM_1MIN		4u
 
 // externally visible variables
-const float RAD_filterLvls[RAD_FILTER_LVL_NUM] = {0.2f, 0.05f, 0.02f}; // exponential smoothing coefficients
-float RAD_filterFactor;
+const uint16_t RAD_filterLvls[RAD_FILTER_LVL_NUM] = {13107u, 3277u, 1311u, RAD_FILTER_ADAPTIVE}; // exponential smoothing coefficients 0.2, 0.05, 0.02 in Q16
+uint16_t RAD_filterFactor;
+RAD_DeadTimeModel_t RAD_deadTimeModel;
 uint16_t RAD_uartLogInterval;
+bool RAD_uartLogBinary;
+
+// HV monitor states, edge counting window is opened & closed by T2 OVF ISR
+typedef enum
+{
+	RAD_HV_IDLE			= 0u,
+	RAD_HV_REQUESTED	= 1u,	// window opens with next sec tick
+	RAD_HV_COUNTING		= 2u,	// window closes with next sec tick
+} RAD_HvState_t;
+
+// total dose checkpoint, CRC covers seq & dose
+typedef struct
+{
+	uint16_t seq;
+	uint32_t dose;	// [nSv]
+	uint16_t crc;
+} RAD_JournalSlot_t;
 
 // internal variables
 static volatile uint16_t hvCounts;	// incremented in PCINT1 ISR
+static volatile RAD_HvState_t hvState;
+static volatile uint16_t hvResult;	// edges counted in last complete window
+static volatile bool hvResultNew;	// set by T2 OVF ISR if window was closed
+static bool hvFault;
+static RAD_HvStats_t hvStats;
+static uint32_t hvEwmaAcc;					// Q3; EWMA of HV edge counts times 2^RAD_HV_EWMA_SHIFT, keeps the remainder
+static uint16_t hvSnaps[RAD_HV_SNAP_NUM];	// Q3; hourly EWMA snapshots
+static byte hvSnapIdx, hvSnapNum;
+static bool detectorCheckPending;	// detector silent, waiting for HV check result
+static uint32_t silenceRate;		// Q16; learned count rate for silence detection
 static volatile uint16_t rawCounts;	// incremented INT1 ISR
-static uint64_t totalCounts;		// max: 1.43GSv - should be sufficient for a while
+static uint32_t totalDose;			// [nSv]; max: 4.29Sv - should be sufficient for a while
+static uint32_t totalDoseRem;		// remainder of totalDose in Q8 counts*100
+static uint32_t journalDose;		// [nSv]; dose of the newest checkpoint
+static uint16_t journalSeq;			// sequence number of the next checkpoint
+static byte journalIdx;				// slot of the next checkpoint
 static uint16_t countBuffer;
-static float doseRate;
+static uint32_t countTotal;			// counts since boot, countBuffer extended to 32bit every second
+static uint32_t doseRate;			// [nSv/h]
+static byte doseRateErr;			// [%]; 95% confidence interval of doseRate
 static bool radFault;
+static byte overRangeHold;			// [s]; >0 while the dose rate is only a lower bound, see CorrectDeadTime()
+
+// dead-time correction factors n/m in Q12, generated by tools/deadtime_lut.py
+// measured rate m*t = x_max*(1-(1-u)^2), u = 0..1, x_max is reached at 5kCPS true rate (n*t = 0.95)
+// dense spacing close to x_max, where the inverse of the paralyzable model gets steep
+// beyond x_max only the non-paralyzable model has a unique inverse, the others are flagged as over-range
+static const __flash uint16_t deadTimeLut[RAD_DT_MODEL_NUM][RAD_DT_LUT_SIZE] =
+{
+	{	// non-paralyzable
+		 4096,  4159,  4223,  4287,  4353,  4419,  4487,  4555,  4624,  4694,  4765,  4836,  4909,
+		 4982,  5056,  5130,  5206,  5281,  5358,  5435,  5512,  5590,  5668,  5747,  5825,  5904,
+		 5983,  6062,  6141,  6220,  6298,  6377,  6454,  6531,  6608,  6684,  6758,  6832,  6905,
+		 6976,  7046,  7114,  7181,  7246,  7309,  7370,  7429,  7485,  7540,  7591,  7640,  7686,
+		 7729,  7769,  7806,  7840,  7870,  7897,  7921,  7941,  7958,  7971,  7980,  7985,  7987
+	},
+	{	// paralyzable
+		 4096,  4143,  4192,  4241,  4291,  4343,  4395,  4448,  4503,  4558,  4615,  4673,  4732,
+		 4792,  4853,  4916,  4980,  5046,  5113,  5181,  5251,  5322,  5395,  5470,  5547,  5625,
+		 5705,  5787,  5871,  5957,  6045,  6135,  6227,  6322,  6419,  6519,  6621,  6726,  6833,
+		 6943,  7057,  7173,  7292,  7415,  7541,  7671,  7804,  7941,  8082,  8227,  8376,  8529,
+		 8687,  8849,  9015,  9186,  9361,  9540,  9722,  9906, 10089, 10265, 10424, 10544, 10591
+	},
+	{	// hybrid
+		 4096,  4148,  4200,  4254,  4309,  4365,  4422,  4480,  4539,  4600,  4661,  4724,  4788,
+		 4853,  4920,  4988,  5058,  5129,  5201,  5275,  5351,  5428,  5506,  5587,  5669,  5753,
+		 5838,  5926,  6015,  6106,  6199,  6294,  6391,  6490,  6592,  6695,  6800,  6908,  7018,
+		 7129,  7243,  7359,  7477,  7597,  7718,  7842,  7966,  8092,  8219,  8347,  8475,  8603,
+		 8729,  8854,  8976,  9094,  9207,  9313,  9410,  9498,  9572,  9633,  9678,  9706,  9715
+	}
+};
+static const __flash uint16_t deadTimeXMax[RAD_DT_MODEL_NUM] = {31928u, 24078u, 26250u}; // Q16; x_max
+static const __flash uint16_t deadTimeScale[RAD_DT_MODEL_NUM] = {8408u, 11148u, 10226u}; // Q12; 1/x_max
+
+// pulse capture variables, single producer (INT1 ISR) / single consumer (main loop) ring buffer
+static volatile uint32_t pulseBuffer[RAD_PULSE_BUF_SIZE];	// [us]; T1 timestamps
+static volatile byte pulseBufIn, pulseBufOut;
+static volatile uint16_t t1Overflows;	// upper 16bit of T1 timestamp, incremented in T1 OVF ISR
+static volatile uint16_t pulseDrops;	// incremented in INT1 ISR if buffer is full
+static volatile uint32_t pulseGaps;		// bit per buffer slot, set if pulses were dropped before that timestamp
+static volatile bool pulseGap;			// pulses were dropped, next stored timestamp follows a gap
+static volatile bool captureEnable;
+static byte captureOwners;			// RAD_CaptureOwner_t bits, capture is enabled while non-zero
+static RAD_PulseStats_t pulseStats;
+
+// dead time & calibration variables
+static uint16_t deadTimeUs;			// [us]
+static uint16_t deadTimeQ24;		// [2^-24 s]
+static bool dtCalActive;			// calibration running, holds RAD_CAP_DTCAL
+static uint32_t dtCalNum;				// intervals evaluated
+
+// pulse stream variables, frame is sent when full or with the next engine tick -> latency <1s
+static bool streamEnable;
+static uint16_t streamDrops;			// pulses lost because frames did not fit into TX buffer
+static byte streamFrame[UART_FRAME_MAX];
+static byte streamLen, streamNum;		// frame length, 0 if no frame started; pulses in frame
+static uint32_t streamLast;				// [us]; timestamp of last pulse in frame
+static uint64_t dtCalSum, dtCalSumSq;	// [us], [us^2]
+
+// pulse interval histogram, updated in INT1 ISR while capture is enabled
+// half-octave index of x = 2*msb(x) + next bit, bins are [2^p, 1.5*2^p) & [1.5*2^p, 2^(p+1))
+static volatile uint16_t intervalHist[RAD_IHIST_NUM];	// saturating counters
+static volatile uint32_t histStamp;	// [us]; timestamp of the previous pulse
+static volatile bool histValid;		// histStamp holds a valid timestamp
+static const __flash byte halfOctaveLut[256] =
+{
+	 0,  0,  2,  3,  4,  4,  5,  5,  6,  6,  6,  6,  7,  7,  7,  7,
+	 8,  8,  8,  8,  8,  8,  8,  8,  9,  9,  9,  9,  9,  9,  9,  9,
+	10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10, 10,
+	11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 12,
+	13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+	13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13, 13,
+	14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+	14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+	14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+	14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14, 14,
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15
+};
+
+// adaptive filter variables
+static RAD_Cusum_t cusumUp, cusumDown;
+static uint16_t adaptWindow;	// [s]; number of samples averaged since last detected change
+
+// rate alarm variables
+static const byte alarmWinLen[RAD_ALARM_WIN_NUM] = {1u, 4u, 16u, 64u}; // [1/4s]
+static volatile uint16_t alarmLimits[RAD_ALARM_WIN_NUM];	// count thresholds, 0=disabled
+static volatile uint16_t alarmCounts;	// counts in current quarter second, incremented in INT1 ISR
+static volatile byte alarmWindow;		// index of current quarter second
+static volatile bool rateAlarm;			// set if any window exceeded its limit
+static uint32_t alarmRate;				// [nSv/h]; alarm level the limits were calculated for
+static RAD_DeadTimeModel_t alarmModel;	// dead-time model the limits were calculated for
+
+// count history variables, all sums are raw counts
+static const __flash byte secSumLen[RAD_SUM_NUM] = {4u, 10u, 16u, 30u, 60u}; // [s]
+static const __flash uint16_t avgLen[RAD_AVG_NUM] = {10u, 60u, 600u, 3600u}; // [s]
+static const __flash byte avgRes[RAD_AVG_NUM] = {1u, 1u, 30u, 60u}; // [s]; windows move in steps of this
+static uint16_t secHist[RAD_HIST_SIZE];
+static uint16_t blockHist30s[RAD_BLOCK_NUM_30S], blockHist1min[RAD_BLOCK_NUM_1MIN]; // escape encoded
+static byte secIdx, blockIdx30s, blockIdx1min;
+static uint32_t secSums[RAD_SUM_NUM];
+static uint32_t sum10min, sum1h;
+static uint16_t histSecs;	// [s]; length of available history, saturates at 1h
 
 // internal function prototypes
 static void ProcessData(void);
+static uint32_t MulFrac(uint32_t a, uint16_t b);
+static uint16_t AdaptiveFactor(uint32_t cps, uint32_t *estimate);
+static bool CusumUpdate(RAD_Cusum_t *c, uint32_t gain, uint32_t loss, uint32_t cps);
+static void UpdateHistory(uint16_t counts);
+static void PushBlock(uint16_t *hist, byte num, byte *idx, uint32_t *sum, uint32_t counts);
+static void CheckAlarmWindows(uint16_t counts);
+static uint32_t CorrectDeadTime(uint32_t cps, bool *over_range);
+static void UpdateDeadTimeCal(uint32_t interval);
+static bool LoadJournal(uint32_t *dose);
+static void WriteJournal(void);
+static uint16_t JournalCrc(const RAD_JournalSlot_t *slot);
+static void SendLogRecord(bool start);
+static byte PutVarint(byte *buf, uint32_t value);
+static byte PutU32(byte *buf, uint32_t value);
+static void StreamPulse(uint32_t timestamp);
+static void FlushStream(void);
+static void UpdateHvStats(uint16_t counts);
+static uint32_t CpsToDoseRate(uint32_t cps);
+static uint16_t ISqrt(uint32_t x);
+static uint16_t PoissonLimit(float mean);
 
 // start & monitor high voltage supply & detector tube
 bool RAD_Init(void)
 {
 	// reset public variables
 	RAD_filterFactor = RAD_filterLvls[0]; // start with fast filter
+	RAD_deadTimeModel = RAD_DT_NONPARALYZABLE;
 	RAD_uartLogInterval = 0;
+	RAD_uartLogBinary = false;
 	
-	// read total counts from EEPROM
-	while (!eeprom_is_ready());
-	float dose = eeprom_read_float((const float*)RAD_DOSE_EEP_ADDR);
+	// restore total dose from newest valid checkpoint, fall back to dose float of older firmware
+	uint32_t dose;
+	if (!LoadJournal(&dose))
+	{
+		float dose_legacy;
+		EEP_Read(RAD_DOSE_EEP_ADDR, &dose_legacy, sizeof(dose_legacy));
+		if (!(dose_legacy >= 0.0f) || (dose_legacy > 4.0e6f)) { dose_legacy = 0.0f; } // erased EEPROM reads as NaN
+		dose = (uint32_t)(dose_legacy*1000.0f);
+	}
 	RAD_SetTotalDose(dose);
+	journalDose = dose;
 	
-	// enable & check high voltage power supply
+	// calibrated dead time, datasheet value if EEPROM is erased
+	uint16_t dead_time;
+	EEP_Read(RAD_DEAD_TIME_EEP_ADDR, &dead_time, sizeof(dead_time));
+	if ((dead_time < RAD_DEAD_TIME_MIN_US) || (dead_time > RAD_DEAD_TIME_MAX_US)) { dead_time = RAD_DEAD_TIME_US; }
+	deadTimeUs = dead_time;
+	deadTimeQ24 = RAD_DEAD_TIME_Q24((uint32_t)dead_time);
+	
+	// enable high voltage power supply, result of the check is evaluated by RAD_EngineTick()
 	GPIO_SetPin(PIN_HV_EN, true);
-	if (!RAD_CheckHv(NULL)) { return false; }
+	RAD_RequestHvCheck();
 	
 	// clear & enable INT1 (falling edge on PIN_PULSE_INT)
 	// according to the datasheet, external edge interrupts can't be used to wake up from power save mode
@@ -75,84 +326,391 @@ void RAD_DeInit(void)
 	GPIO_SetPin(PIN_HV_EN, false);
 	CLR(EIMSK, INT1);
 	CLR(PCICR, PCIE1);
+	hvState = RAD_HV_IDLE;
+	RAD_SetCapture(RAD_CAP_ALL, false);
 }
 
-// monitor high voltage boost converter for malfunction
-// returns false if too many or too little pulses are detected in given time
-bool RAD_CheckHv(uint16_t *counts)
+// enable or disable timestamp capture of every pulse
+// T1 runs from the I/O clock with 1us resolution, which is halted in power save mode
+// PWR_SleepMode() therefore uses idle mode while capture is enabled
+// note: UART calibration resets T1 and will cause a glitch in the captured timestamps
+// every owner holds capture independently, it is disabled when the last owner releases it
+void RAD_SetCapture(RAD_CaptureOwner_t owner, bool enable)
 {
-	// reset counter variable
-	hvCounts = 0;
+	byte owners = enable ? (captureOwners | owner) : (captureOwners & ~owner);
 	
-	// clear & enable PCINT12 = PC4 = PIN_HV_GATE on PCINT1
-	SET(PCMSK1, PCINT12);
-	CLR_FLAG(PCIFR, PCIF1);
-	SET(PCICR, PCIE1);
+	// stream & calibration need the timestamps, they stop only when their own owner releases capture
+	if (!enable && (owner & RAD_CAP_USER))
+	{
+		streamEnable = false;
+		streamLen = 0;
+	}
+	if (!enable && (owner & RAD_CAP_DTCAL)) { dtCalActive = false; }
 	
-	// count number of edges in 100ms
-	_delay_ms(100);
-	CLR(PCICR, PCIE1); // disable HV monitor interrupt
-	if (counts != NULL) { *counts = hvCounts; }
+	captureOwners = owners;
+	enable = (owners != 0);
+	if (enable == captureEnable) { return; } // other owners keep it running
 	
-	// HV gate pin should see a reasonable number of pulses
-	return (hvCounts>RAD_HV_MIN_PULSES) && (hvCounts<RAD_HV_MAX_PULSES);
+	if (enable)
+	{
+		// reset statistics & flush buffer
+		memset(&pulseStats, 0, sizeof(pulseStats));
+		pulseStats.minInterval = UINT32_MAX;
+		pulseBufIn = pulseBufOut = 0;
+		pulseDrops = 0;
+		pulseGaps = 0;
+		pulseGap = false;
+		histValid = false; // histogram is kept, interval across disabled capture would be invalid
+		
+		// extend T1 to 32bit with overflow interrupt
+		t1Overflows = 0;
+		CLR_FLAG(TIFR1, TOV1);
+		SET(TIMSK1, TOIE1);
+	}
+	else { CLR(TIMSK1, TOIE1); }
+	
+	captureEnable = enable;
+}
+
+// returns true if pulse capture is enabled
+bool RAD_GetCapture(void)
+{
+	return captureEnable;
+}
+
+// drain timestamp buffer & evaluate pulse intervals, call this from main loop
+void RAD_ProcessPulses(void)
+{
+	static uint32_t last_pulse;
+	
+	while (pulseBufOut != pulseBufIn)
+	{
+		// slot is not touched by ISR until index is advanced
+		uint32_t timestamp = pulseBuffer[pulseBufOut];
+		uint32_t slot = 1ul << pulseBufOut;
+		bool gap = pulseGaps & slot;
+		if (gap) { ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { pulseGaps &= ~slot; } }
+		pulseBufOut = (pulseBufOut + 1) & (RAD_PULSE_BUF_SIZE - 1);
+		
+		// first pulse has no predecessor, unsigned math handles 71min wrap around
+		if (pulseStats.count++)
+		{
+			uint32_t interval = timestamp - last_pulse;
+			pulseStats.lastInterval = interval;
+			if (interval < pulseStats.minInterval) { pulseStats.minInterval = interval; }
+			
+			// intervals spanning dropped pulses would bias the calibration & random bits
+			if (!gap)
+			{
+				if (dtCalActive) { UpdateDeadTimeCal(interval); }
+				RNG_AddInterval(interval);
+			}
+		}
+		last_pulse = timestamp;
+		
+		if (streamEnable) { StreamPulse(timestamp); }
+	}
+}
+
+// stream timestamp of every captured pulse to UART in binary frames, see tools/binlog_decode.py
+// capture must be enabled by the user, releasing it also stops the stream
+void RAD_SetPulseStream(bool enable)
+{
+	if (enable && !(captureOwners & RAD_CAP_USER)) { return; }
+	
+	if (enable && !streamEnable)
+	{
+		streamDrops = 0;
+		streamLen = 0;
+	}
+	streamEnable = enable;
+}
+
+// get inter-arrival statistics of captured pulses
+RAD_PulseStats_t RAD_GetPulseStats(void)
+{
+	RAD_PulseStats_t stats;
+	
+	// drop counter is written by ISR
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		stats = pulseStats;
+		stats.drops = pulseDrops;
+		stats.linkDrops = streamDrops;
+	}
+	
+	return stats;
+}
+
+// start dead-time calibration, enables pulse capture until finished
+// a strong source should be placed close to the tube, result is stored in EEPROM if precise enough
+void RAD_StartDeadTimeCal(void)
+{
+	dtCalNum = 0;
+	dtCalSum = dtCalSumSq = 0;
+	RAD_SetCapture(RAD_CAP_DTCAL, true);
+	dtCalActive = true;
+}
+
+// returns true while calibration is running, number of evaluated intervals so far
+bool RAD_GetDeadTimeCal(uint32_t *samples)
+{
+	*samples = dtCalNum;
+	return dtCalActive;
+}
+
+// return dead time in us
+uint16_t RAD_GetDeadTime(void)
+{
+	return deadTimeUs;
+}
+
+// set dead time in us & store it in EEPROM, returns false if out of range
+bool RAD_SetDeadTime(uint16_t dead_time)
+{
+	if ((dead_time < RAD_DEAD_TIME_MIN_US) || (dead_time > RAD_DEAD_TIME_MAX_US)) { return false; }
+	
+	deadTimeUs = dead_time;
+	deadTimeQ24 = RAD_DEAD_TIME_Q24((uint32_t)dead_time);
+	EEP_Write(RAD_DEAD_TIME_EEP_ADDR, &dead_time, sizeof(dead_time));
+	
+	// alarm limits depend on dead time
+	RAD_SetAlarmLevel(alarmRate);
+	
+	return true;
+}
+
+// get count of one pulse interval histogram bin, see RAD_GetIntervalHistBin() for its bounds
+uint16_t RAD_GetIntervalHist(byte bin)
+{
+	uint16_t count;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { count = intervalHist[bin]; } // written by INT1 ISR
+	return count;
+}
+
+// clear pulse interval histogram
+void RAD_ResetIntervalHist(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for (byte i=0; i<RAD_IHIST_NUM; i++) { intervalHist[i] = 0; }
+	}
+}
+
+// return lower bound of a histogram bin in us, first bin starts at 0
+uint32_t RAD_GetIntervalHistBin(byte bin)
+{
+	if (!bin) { return 0; }
+	
+	byte idx = bin - 1 + RAD_IHIST_BIN_MIN;
+	byte msb = idx >> 1;
+	return (idx & 1) ? (3ul << (msb - 1)) : (1ul << msb);
+}
+
+// set rate alarm level in nSv/h, 0 disables the alarm
+// calculates the count limits for every window, takes some ms for low levels - call this only if level changed
+void RAD_SetAlarmLevel(uint32_t rate)
+{
+	alarmRate = rate;
+	alarmModel = RAD_deadTimeModel;
+	
+	// convert to raw CPS as seen by the detector: n*exp(-a*n*t)/(1+(1-a)*n*t)
+	float a = 0.0f;
+	if (alarmModel == RAD_DT_PARALYZABLE) { a = 1.0f; }
+	else if (alarmModel == RAD_DT_HYBRID) { a = RAD_DT_HYBRID_A; }
+	float cps = rate*(float)RAD_CONV_FACTOR/60000.0f;
+	float y = cps*(deadTimeUs/1.0e6f);
+	cps *= expf(-a*y) / (1.0f + (1.0f - a)*y);
+	
+	for (byte i=0; i<RAD_ALARM_WIN_NUM; i++)
+	{
+		uint16_t limit = rate ? PoissonLimit(cps*alarmWinLen[i]/4.0f) : 0;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { alarmLimits[i] = limit; }
+	}
+}
+
+// returns true if any count window exceeded the alarm limit since last call
+bool RAD_CheckRateAlarm(void)
+{
+	if (rateAlarm)
+	{
+		rateAlarm = false;
+		return true;
+	}
+	
+	return false;
+}
+
+// get boxcar average of the dose rate in nSv/h over the given window, dead-time corrected
+// 10min & 1h windows move in steps of 30s & 1min, returns false if no complete step is available yet
+bool RAD_GetAvgDoseRate(RAD_AvgWindow_t win, uint32_t *rate)
+{
+	uint32_t sum;
+	switch (win)
+	{
+		case RAD_AVG_10S:	{ sum = secSums[RAD_SUM_10S]; break; }
+		case RAD_AVG_1MIN:	{ sum = secSums[RAD_SUM_1MIN]; break; }
+		case RAD_AVG_10MIN:	{ sum = sum10min; break; }
+		case RAD_AVG_1H:	{ sum = sum1h; break; }
+		default:			{ return false; }
+	}
+	
+	// shorter history -> average over what is available
+	uint16_t secs = histSecs - (histSecs % avgRes[win]);
+	if (secs > avgLen[win]) { secs = avgLen[win]; }
+	if (!secs) { return false; }
+	
+	// mean CPS in Q8, split to avoid overflow of long windows
+	uint32_t cps = ((sum / secs) << 8) + (((sum % secs) << 8) / secs);
+	*rate = CpsToDoseRate(CorrectDeadTime(cps, NULL) << 8);
+	return true;
+}
+
+// request a check of the high voltage boost converter, doesn't block
+// edges on the HV gate pin are counted for one second, starting with the next sec tick
+// the result is available ~1-2s later, see RAD_GetHvCounts()
+void RAD_RequestHvCheck(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (hvState == RAD_HV_IDLE) { hvState = RAD_HV_REQUESTED; }
+	}
+}
+
+// get number of HV gate edges counted in the last completed check
+uint16_t RAD_GetHvCounts(void)
+{
+	uint16_t counts;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { counts = hvResult; }
+	return counts;
+}
+
+// get long-term statistics of the HV gate edge counts
+RAD_HvStats_t RAD_GetHvStats(void)
+{
+	return hvStats;
 }
 
 // return false if counter is suspiciously silent
+// probability of n silent seconds at rate r is exp(-r*n) -> fault after ln(1/p_fa)/r seconds, capped at RAD_MAX_PULSE_INTERVAL
+// limit is based on the rate learned before the silence began, so detection latency scales with the dose rate
+// the EWMA forgets a high rate slowly, so every finished gap caps it to ln(100)/gap -> after a rate drop the limit
+// grows with the observed gaps within a few pulses instead of tripping on normal background gaps for minutes
+// must be called once per second
 bool RAD_DetectorCheck(void)
 {
 	static uint16_t counts_old;
-	static uint32_t last_pulse_timestamp;
+	static uint16_t silent_secs, silent_limit = RAD_MAX_PULSE_INTERVAL;
+	
+	uint16_t counts = countBuffer - counts_old; // overflow is intentional
+	counts_old = countBuffer;
 	
-	if (countBuffer != counts_old)
+	if (counts)
 	{
-		uint32_t uptime = RTC_GetUpTime();
-
 #if (RAD_DEBUG)
-		static uint32_t longest_pause;
-		uint32_t pause = uptime - last_pulse_timestamp;
-		if (pause > longest_pause)
+		static uint16_t longest_pause;
+		if (silent_secs > longest_pause)
 		{
-			longest_pause = pause;
-			UART_Printf("t_up: %u, p_max: %u\n", (uint16_t)uptime, (uint16_t)longest_pause);
+			longest_pause = silent_secs;
+			UART_Printf("t_up: %u, p_max: %u\n", (uint16_t)RTC_GetUpTime(), longest_pause);
 		}
 #endif
-		// new radiation event detected
-		counts_old = countBuffer;
-		last_pulse_timestamp = uptime;
+		// rate implied by the gap that just ended, the limit stays >3x the longest plausible gap
+		if (silent_secs)
+		{
+			uint32_t gap_rate = RAD_SILENCE_GAP_LN_Q16 / silent_secs;
+			if (silenceRate > gap_rate) { silenceRate = gap_rate; }
+		}
+		
+		// new radiation event detected, ceil(ln(1/p_fa)/r)
+		silent_secs = 0;
+		uint32_t limit = silenceRate ? ((RAD_SILENCE_LN_Q16 + silenceRate - 1) / silenceRate) : RAD_MAX_PULSE_INTERVAL;
+		silent_limit = (limit < RAD_MAX_PULSE_INTERVAL) ? limit : RAD_MAX_PULSE_INTERVAL;
 	}
-	else if (RTC_GetUpTime() > (last_pulse_timestamp + RAD_MAX_PULSE_INTERVAL))
+	else if (silent_secs < UINT16_MAX)
 	{
-		// timeout, no pulses detected at all -> HV supply, tube or pulse amp might be defective
-		return false;
+		silent_secs++;
 	}
 	
-	return true;
+	// learn count rate of the last ~1min, silent seconds included
+	// updated after the limit, otherwise the pulse that ends a silence would bias the limit low
+	silenceRate += ((int32_t)((uint32_t)counts << 16) - (int32_t)silenceRate) / (1 << RAD_SILENCE_RATE_SHIFT);
+	
+	// timeout, no pulses detected at all -> HV supply, tube or pulse amp might be defective
+	return (silent_secs < silent_limit);
 }
 
 // monitor HV & tube, process radiation data, handle logging
 void RAD_EngineTick(void)
 {
 	RTC_Time_t time = RTC_GetSysTime();
+	
+	// send pending pulse stream frame
+	if (streamLen) { FlushStream(); }
+	
+	// fetch result of HV check, window was closed by the sec tick that triggered this call
+	bool hv_new;
+	uint16_t hv_counts;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		hv_new = hvResultNew;
+		hvResultNew = false;
+		hv_counts = hvResult;
+	}
+	
+	// HV gate pin should see a reasonable number of pulses
+	if (hv_new && !hvFault && ((hv_counts < RAD_HV_MIN_PULSES) || (hv_counts > RAD_HV_MAX_PULSES)))
+	{
+		hvFault = true;
+		radFault = true;
+		detectorCheckPending = false;
+		GPIO_SetPin(PIN_HV_EN, false);
+		UART_Printf("%02u:%02u:%02u ", time.hours, time.mins, time.secs);
+		UART_Printf("HV FAULT !!! %u\n", hv_counts);
+	}
+	if (hvFault) { return; } // nothing else to do
+	
+	// track converter load, warn early if it drifts
+	bool hv_warn = hvStats.warning;
+	if (hv_new) { UpdateHvStats(hv_counts); }
+	if (hvStats.warning != hv_warn)
+	{
+		UART_Printf("%02u:%02u:%02u ", time.hours, time.mins, time.secs);
+		if (hvStats.warning)
+		{
+			char drift_str[FMT_BUF_SIZE];
+			FMT_FixedQ(drift_str, hvStats.drift, RAD_HV_STATS_Q, 1);
+			UART_Printf("HV WARNING! %u drift %s/d\n", hv_counts, drift_str);
+		}
+		else { UART_Printf("HV warning cleared..\n"); }
+	}
+	
+	// periodic HV check & hourly snapshot for drift estimation
+	uint32_t uptime = RTC_GetUpTime();
+	if (!(uptime % RAD_HV_CHECK_INTERVAL)) { RAD_RequestHvCheck(); }
+	if (!(uptime % 3600u) && hvStats.samples)
+	{
+		hvSnaps[hvSnapIdx] = hvStats.ewma;
+		if (++hvSnapIdx >= RAD_HV_SNAP_NUM) { hvSnapIdx = 0; }
+		if (hvSnapNum < RAD_HV_SNAP_NUM) { hvSnapNum++; }
+	}
 
 	// no pulses detected in a long time
 	if (!RAD_DetectorCheck())
 	{
-		// print error only once
-		if (radFault) { return; }
-		radFault = true;
-		
-		UART_Printf("%02u:%02u:%02u ", time.hours, time.mins, time.secs);
-		
-		// check HV driver signal
-		uint16_t counts;
-		if (!RAD_CheckHv(&counts))
+		// check HV driver signal first, report once
+		if (!radFault)
 		{
-			GPIO_SetPin(PIN_HV_EN, false);
-			UART_Printf("HV FAULT !!! %u\n", counts);
+			radFault = true;
+			detectorCheckPending = true;
+			RAD_RequestHvCheck();
 		}
-		else // if HV supply is OK -> detector must be defective
+		
+		// if HV supply is OK -> detector must be defective
+		if (detectorCheckPending && hv_new)
 		{
+			detectorCheckPending = false;
+			UART_Printf("%02u:%02u:%02u ", time.hours, time.mins, time.secs);
 			UART_Printf("DETECTOR FAULT !!!\n");
 		}
 		
@@ -161,7 +719,8 @@ void RAD_EngineTick(void)
 	else if (radFault)
 	{
 		// detector fault recovered
-		radFault = false;	
+		radFault = false;
+		detectorCheckPending = false;
 		UART_Printf("%02u:%02u:%02u ", time.hours, time.mins, time.secs);
 		UART_Printf("Detector recovered..\n");
 	}
@@ -169,25 +728,51 @@ void RAD_EngineTick(void)
 	// crunch some numbers
 	ProcessData();
 	
-	// log radiation data to UART
-	static bool log_head = false;
-	if (RAD_uartLogInterval)
+	// dose rate beyond the dead-time correction range is only a lower bound, report changes once
+	static bool over_range_old;
+	if (RAD_GetOverRange() != over_range_old)
+	{
+		over_range_old = !over_range_old;
+		UART_Printf("%02u:%02u:%02u ", time.hours, time.mins, time.secs);
+		if (over_range_old) { UART_Printf("DOSE RATE OVER RANGE !!!\n"); }
+		else { UART_Printf("Dose rate in range..\n"); }
+	}
+	
+	// checkpoint total dose, survives brown-out & watchdog reset
+	if (!(RTC_GetUpTime() % RAD_JOURNAL_INTERVAL) && (totalDose != journalDose)) { WriteJournal(); }
+	
+	// log radiation data to UART, binary frames or human readable
+	static bool log_head = false, log_binary = false;
+	if (RAD_uartLogInterval && RAD_uartLogBinary)
+	{
+		if (!log_binary) { SendLogRecord(true); } // counts of the first record start now
+		log_binary = true;
+		if (!(RTC_GetSecTime() % RAD_uartLogInterval)) { SendLogRecord(false); }
+		log_head = false;
+	}
+	else if (RAD_uartLogInterval)
 	{
 		if (!log_head)
 		{
 			UART_Printf("Time     Rate       Total\n");
 			log_head = true;
 		}
+		log_binary = false;
 		
 		if (!(RTC_GetSecTime() % RAD_uartLogInterval))
 		{
-			UART_Printf("%02u:%02u:%02u ", time.hours, time.mins, time.secs);
-			UART_Printf("%.3fuSv/h %.4fuSv\n", (double)doseRate, (double)RAD_GetTotalDose());
+			char rate_str[FMT_BUF_SIZE], dose_str[FMT_BUF_SIZE];
+			FMT_Time(rate_str, time.hours, time.mins, time.secs);
+			UART_Printf("%s ", rate_str);
+			FMT_Fixed(rate_str, doseRate, 3, 3);
+			FMT_Fixed(dose_str, RAD_GetTotalDose(), 3, 4);
+			UART_Printf("%suSv/h %suSv%s\n", rate_str, dose_str, RAD_GetOverRange() ? " OVER RANGE" : "");
 		}
 	}
 	else
 	{
 		log_head = false;
+		log_binary = false;
 	}
 }
 
@@ -200,63 +785,575 @@ void RAD_UpdateBuffer(void)
 	{
 		countBuffer = rawCounts;
 	}
+	
+	// quarter second windows are counted relative to T2 overflow
+	alarmWindow = RAD_ALARM_WIN_NONE;
+	
+	// HV monitor edge counting window
+	if (hvState == RAD_HV_COUNTING)
+	{
+		CLR(PCICR, PCIE1); // disable HV monitor interrupt
+		hvResult = hvCounts;
+		hvResultNew = true;
+		hvState = RAD_HV_IDLE;
+	}
+	else if (hvState == RAD_HV_REQUESTED)
+	{
+		// clear & enable PCINT12 = PC4 = PIN_HV_GATE on PCINT1
+		hvCounts = 0;
+		SET(PCMSK1, PCINT12);
+		CLR_FLAG(PCIFR, PCIF1);
+		SET(PCICR, PCIE1);
+		hvState = RAD_HV_COUNTING;
+	}
 }
 
-// return current dose rate
-float RAD_GetDoseRate(void)
+// return current dose rate in nSv/h
+uint32_t RAD_GetDoseRate(void)
 {
 	return doseRate;
 }
 
+// return relative 95% confidence interval of dose rate in percent
+byte RAD_GetDoseRateErr(void)
+{
+	return doseRateErr;
+}
+
 // returns true if fault occurred
 bool RAD_GetFault(void)
 {
 	return radFault;
 }
 
+// returns true if the count rate recently exceeded the dead-time correction range -> dose rate is a lower bound
+bool RAD_GetOverRange(void)
+{
+	return (overRangeHold != 0);
+}
+
 // call this every second to update radiation data
 // as long as this is called soon after sectick ISR, there is no risk of countBuffer being changed while this runs
+// all math is done in fixed-point, rates are kept as Q8 / Q16 counts per second
+// deviation from the analytic dead-time models is <0.07% below 5kCPS (paralyzable: <0.32% close to saturation)
 static void ProcessData(void)
 {
 	// static local vars
 	static uint16_t buffer_old;
-	static float cpm_smooth;
+	static uint32_t cps_smooth;	// Q16
+	static uint32_t var_factor = 65536ul; // Q16; sum of squared sample weights, effective number of samples is 1/var_factor
+	static uint16_t factor_old;
 	
 	// dose rate calculation - handle intermediate buffer
 	uint16_t cps = countBuffer - buffer_old;
 	buffer_old = countBuffer;
+	countTotal += cps;
+	UpdateHistory(cps);
+	CheckAlarmWindows(cps);
 	
-	// dead-time correction
-	float cps_corr = cps/(1.0f - cps*RAD_DEAD_TIME);
+	// dead-time correction, result in Q8
+	uint32_t cps_corr = 0;
+	bool over_range = false;
+	if (cps)
+	{
+		cps_corr = CorrectDeadTime((uint32_t)cps << 8, &over_range);
+		
+		// total dose calculation - keep remainder to avoid rounding errors
+		uint32_t acc = totalDoseRem + cps_corr*100u;
+		totalDose += acc / RAD_DOSE_DIV_Q8;
+		totalDoseRem = acc % RAD_DOSE_DIV_Q8;
+	}
 	
-	// CPM estimation & exponential smoothing of CPM value
-	cpm_smooth = RAD_filterFactor*(60.0f*cps_corr) + (1-RAD_filterFactor)*cpm_smooth;
+	// beyond the correction range the estimate is a lower bound, flag it until the filter caught up
+	if (over_range) { overRangeHold = RAD_OVER_RANGE_HOLD; }
+	else if (overRangeHold) { overRangeHold--; }
 	
-	// CPM to dose rate conversion
-	doseRate = cpm_smooth / RAD_CONV_FACTOR;
+	// adaptive mode: continue with an averaging window equivalent to the previous filter setting
+	uint32_t cps_q16 = cps_corr << 8;
+	uint16_t factor = RAD_filterFactor;
+	if (factor == RAD_FILTER_ADAPTIVE)
+	{
+		if (factor_old != RAD_FILTER_ADAPTIVE)
+		{
+			uint32_t window = 131071ul/factor_old; // 2/f-1 samples, same noise as EMA with factor f
+			adaptWindow = (window < RAD_ADAPT_MAX_WINDOW) ? (uint16_t)window : RAD_ADAPT_MAX_WINDOW;
+			memset(&cusumUp, 0, sizeof(cusumUp));
+			memset(&cusumDown, 0, sizeof(cusumDown));
+		}
+		factor = AdaptiveFactor(cps_q16, &cps_smooth);
+	}
+	factor_old = RAD_filterFactor;
+	
+	// exponential smoothing of CPS value in Q16: s += f*(x-s)
+	if (cps_q16 > cps_smooth) { cps_smooth += MulFrac(cps_q16 - cps_smooth, factor); }
+	else { cps_smooth -= MulFrac(cps_smooth - cps_q16, factor); }
+	
+	// track variance of the estimate relative to a single sample: v = (1-f)^2*v + f^2
+	// adaptive filter reset the estimate to the average of its window -> v = 1/n
+	if (factor) { var_factor = MulFrac(MulFrac(var_factor, 65536ul - factor), 65536ul - factor) + MulFrac(factor, factor); }
+	else { var_factor = 65536ul / adaptWindow; }
+	
+	// CPS to dose rate conversion
+	doseRate = CpsToDoseRate(cps_smooth);
 	
-	// total dose calculation - use int to avoid float rounding errors
-	totalCounts += (uint64_t)roundf(cps_corr);
+	// Poisson counts behind the estimate: cps/v -> relative 95% confidence interval 1.96*sqrt(v/cps)
+	// v/cps in Q16, square root in Q8
+	uint32_t cps_q8 = cps_smooth >> 8;
+	doseRateErr = RAD_RATE_ERR_MAX;
+	if (cps_q8)
+	{
+		uint32_t err = (196u*(uint32_t)ISqrt((var_factor << 8) / cps_q8)) >> 8;
+		if (err < RAD_RATE_ERR_MAX) { doseRateErr = err; }
+	}
 }
 
-// set total accumulated dose value
-void RAD_SetTotalDose(float dose)
+// set total accumulated dose value in nSv
+void RAD_SetTotalDose(uint32_t dose)
 {
-	totalCounts = (dose * 60.0f * RAD_CONV_FACTOR);
+	totalDose = dose;
+	totalDoseRem = 0;
 }
 
-// get total accumulated dose rate
-float RAD_GetTotalDose(void)
+// get total accumulated dose in nSv
+uint32_t RAD_GetTotalDose(void)
 {
-	return totalCounts / (60.0f * RAD_CONV_FACTOR);
+	return totalDose;
 }
 
-// save total accumulated dose to EEPROM
+// save total accumulated dose to EEPROM as a new checkpoint
 void RAD_SaveTotalDose(void)
 {
-	float dose = RAD_GetTotalDose();
-	while (!eeprom_is_ready());
-	eeprom_update_float((float*)RAD_DOSE_EEP_ADDR, dose);
+	if (totalDose != journalDose) { WriteJournal(); }
+}
+
+// find newest valid checkpoint, sequence numbers are compared with wrap around
+// returns false if there is none, next checkpoint goes to the slot after the newest one
+static bool LoadJournal(uint32_t *dose)
+{
+	bool found = false;
+	RAD_JournalSlot_t newest = {0};
+	
+	journalIdx = 0;
+	journalSeq = 0;
+	for (byte i=0; i<RAD_JOURNAL_SLOT_NUM; i++)
+	{
+		RAD_JournalSlot_t slot;
+		EEP_Read(RAD_JOURNAL_START + i*sizeof(slot), &slot, sizeof(slot));
+		
+		// torn writes & erased slots fail the CRC
+		if (slot.crc != JournalCrc(&slot)) { continue; }
+		if (found && ((int16_t)(slot.seq - newest.seq) <= 0)) { continue; }
+		
+		found = true;
+		newest = slot;
+		journalIdx = (i + 1) % RAD_JOURNAL_SLOT_NUM;
+		journalSeq = slot.seq + 1;
+	}
+	
+	*dose = newest.dose;
+	return found;
+}
+
+// queue total dose for the next checkpoint slot, written in the background within ~27ms
+static void WriteJournal(void)
+{
+	RAD_JournalSlot_t slot = {.seq = journalSeq, .dose = totalDose};
+	slot.crc = JournalCrc(&slot);
+	
+	EEP_Write(RAD_JOURNAL_START + journalIdx*sizeof(slot), &slot, sizeof(slot));
+	
+	journalDose = slot.dose;
+	journalSeq++;
+	if (++journalIdx >= RAD_JOURNAL_SLOT_NUM) { journalIdx = 0; }
+}
+
+// CRC-CCITT of checkpoint without the CRC field
+static uint16_t JournalCrc(const RAD_JournalSlot_t *slot)
+{
+	const byte *data = (const byte*)slot;
+	uint16_t crc = 0xFFFF;
+	for (byte i=0; i<offsetof(RAD_JournalSlot_t, crc); i++) { crc = _crc_ccitt_update(crc, data[i]); }
+	return crc;
+}
+
+// send binary log record, delta encoded against the previous one
+// ~10 bytes per record instead of ~35 ASCII chars, no float formatting
+// start: logging was just enabled, counts of the first record begin here, nothing is sent
+static void SendLogRecord(bool start)
+{
+	static uint32_t last_uptime, last_rate, last_dose, last_counts;
+	static byte records; // since last key record, 0 forces a key record
+	
+	if (start)
+	{
+		last_counts = countTotal;
+		records = 0;
+		return;
+	}
+	
+	uint32_t uptime = RTC_GetUpTime();
+	uint32_t raw = countTotal;
+	uint32_t counts = raw - last_counts; // since previous record, overflow is intentional
+	uint32_t rate = doseRate;
+	uint32_t dose = totalDose;
+	byte buf[1 + 5 + 5 + 5 + 5]; // worst case delta record
+	byte len = 0;
+	
+	// dose can be reset or set lower by user, deltas must be positive
+	if (!records || (records >= RAD_LOG_KEY_INTERVAL) || (dose < last_dose))
+	{
+		buf[len++] = RAD_LOG_KEY;
+		len += PutU32(&buf[len], uptime);
+		len += PutU32(&buf[len], counts);
+		len += PutU32(&buf[len], rate);
+		len += PutU32(&buf[len], dose);
+		records = 0;
+	}
+	else
+	{
+	int32_t rate_delta = rate - last_rate;
+		buf[len++] = RAD_LOG_DELTA;
+		len += PutVarint(&buf[len], uptime - last_uptime);
+		len += PutVarint(&buf[len], counts);
+		len += PutVarint(&buf[len], ((uint32_t)rate_delta << 1) ^ (uint32_t)(rate_delta >> 31)); // zigzag
+		len += PutVarint(&buf[len], dose - last_dose);
+	}
+	
+	// receiver lost the reference if frame didn't fit into TX buffer
+	if (!UART_SendFrame(buf, len))
+	{
+		records = 0;
+		return;
+	}
+	
+	records++;
+	last_uptime = uptime;
+	last_counts = raw;
+	last_rate = rate;
+	last_dose = dose;
+}
+
+// add pulse to stream frame, absolute timestamp for the first one & intervals for the following
+static void StreamPulse(uint32_t timestamp)
+{
+	if (!streamLen)
+	{
+		streamFrame[0] = RAD_LOG_PULSES;
+		PutU32(&streamFrame[5], timestamp);
+		streamLen = RAD_LOG_PULSES_HEAD;
+		streamNum = 1;
+	}
+	else
+	{
+		streamLen += PutVarint(&streamFrame[streamLen], timestamp - streamLast);
+		streamNum++;
+	}
+	streamLast = timestamp;
+	
+	// send if next interval might not fit anymore
+	if (streamLen > (UART_FRAME_MAX - 5u)) { FlushStream(); }
+}
+
+// send stream frame with current drop counters, pulses are counted as lost if TX buffer is full
+static void FlushStream(void)
+{
+	uint16_t drops;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { drops = pulseDrops; }
+	streamFrame[1] = drops & 0xFF;
+	streamFrame[2] = drops >> 8;
+	streamFrame[3] = streamDrops & 0xFF;
+	streamFrame[4] = streamDrops >> 8;
+	
+	if (!UART_SendFrame(streamFrame, streamLen)) { streamDrops += streamNum; }
+	streamLen = 0;
+}
+
+// LEB128 encoding, 7 bits per byte, MSB set if more bytes follow; returns number of bytes
+static byte PutVarint(byte *buf, uint32_t value)
+{
+	byte len = 0;
+	while (value >= 0x80)
+	{
+		buf[len++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	buf[len++] = value;
+	return len;
+}
+
+// little endian uint32, returns number of bytes
+static byte PutU32(byte *buf, uint32_t value)
+{
+	for (byte i=0; i<4; i++)
+	{
+		buf[i] = value & 0xFF;
+		value >>= 8;
+	}
+	return 4;
+}
+
+// multiply with Q16 fraction b, floor(a*b/2^16) without 64bit math
+static uint32_t MulFrac(uint32_t a, uint16_t b)
+{
+	return (a >> 16)*b + (((a & 0xFFFF)*b) >> 16);
+}
+
+// adaptive filter, returns smoothing factor for the Q16 CPS sample
+// stable rate: factor 1/n -> cumulative average over the last n samples, n is limited to RAD_ADAPT_MAX_WINDOW
+// two CUSUM log-likelihood tests watch for the rate doubling or halving
+// on detection, the estimate is replaced by the average since the change began & the window restarts from there
+static uint16_t AdaptiveFactor(uint32_t cps, uint32_t *estimate)
+{
+	uint32_t lambda = *estimate;
+	uint32_t cps_ln2 = MulFrac(cps, RAD_LN2_Q16);
+	RAD_Cusum_t *c = NULL;
+	
+	// log-likelihood ratio Poisson(2*lambda) vs. Poisson(lambda): x*ln2 - lambda
+	if (CusumUpdate(&cusumUp, cps_ln2, lambda, cps)) { c = &cusumUp; }
+	// log-likelihood ratio Poisson(lambda/2) vs. Poisson(lambda): lambda/2 - x*ln2
+	if (CusumUpdate(&cusumDown, lambda >> 1, cps_ln2, cps)) { c = &cusumDown; }
+	
+	if (c != NULL)
+	{
+		// step change detected, sum is Q8, estimate Q16
+		*estimate = (c->sum / c->len) << 8;
+		adaptWindow = c->len;
+		memset(&cusumUp, 0, sizeof(cusumUp));
+		memset(&cusumDown, 0, sizeof(cusumDown));
+		return 0; // keep new estimate
+	}
+	
+	if (adaptWindow < RAD_ADAPT_MAX_WINDOW) { adaptWindow++; }
+	return (uint16_t)(65535u / adaptWindow);
+}
+
+// one sided CUSUM step: s = max(0, s+gain-loss), returns true if decision threshold is exceeded
+// samples are summed up since s last left zero, i.e. since the presumed change point
+static bool CusumUpdate(RAD_Cusum_t *c, uint32_t gain, uint32_t loss, uint32_t cps)
+{
+	if ((c->s + gain) <= loss)
+	{
+		memset(c, 0, sizeof(*c));
+		return false;
+	}
+	
+	c->s += gain - loss;
+	if (c->len < UINT8_MAX)
+	{
+		c->sum += cps >> 8; // 255 samples of RAD_RATE_MAX_Q8 still fit
+		c->len++;
+	}
+	
+	return (c->s > RAD_ADAPT_THRESHOLD);
+}
+
+// update min, max, EWMA & drift of HV gate edge counts, raise warning on unusual behaviour
+static void UpdateHvStats(uint16_t counts)
+{
+	uint16_t counts_q3 = (counts < (UINT16_MAX >> RAD_HV_STATS_Q)) ? (counts << RAD_HV_STATS_Q) : UINT16_MAX;
+	
+	hvStats.last = counts;
+	if (hvStats.samples < UINT16_MAX) { hvStats.samples++; }
+	if (hvStats.samples == 1)
+	{
+		hvStats.min = hvStats.max = counts;
+		hvEwmaAcc = (uint32_t)counts_q3 << RAD_HV_EWMA_SHIFT;
+	}
+	else
+	{
+		if (counts < hvStats.min) { hvStats.min = counts; }
+		if (counts > hvStats.max) { hvStats.max = counts; }
+		hvEwmaAcc += counts_q3 - (hvEwmaAcc >> RAD_HV_EWMA_SHIFT); // acc*(1-f) + x, no truncation bias
+	}
+	hvStats.ewma = (hvEwmaAcc + (1u << (RAD_HV_EWMA_SHIFT - 1))) >> RAD_HV_EWMA_SHIFT;
+	
+	// drift per day from oldest & newest hourly snapshot
+	hvStats.drift = 0;
+	if (hvSnapNum >= RAD_HV_SNAP_MIN)
+	{
+		uint16_t newest = hvSnaps[(hvSnapIdx + RAD_HV_SNAP_NUM - 1) % RAD_HV_SNAP_NUM];
+		uint16_t oldest = hvSnaps[(hvSnapIdx + RAD_HV_SNAP_NUM - hvSnapNum) % RAD_HV_SNAP_NUM];
+		int32_t drift = ((int32_t)newest - oldest)*24 / (hvSnapNum - 1);
+		hvStats.drift = (drift > INT16_MAX) ? INT16_MAX : ((drift < -INT16_MAX) ? -INT16_MAX : drift);
+	}
+	
+	// warn if converter load drifts or single sample is way off
+	uint32_t drift_abs = (hvStats.drift < 0) ? -(int32_t)hvStats.drift : hvStats.drift;
+	uint32_t dev = (counts_q3 > hvStats.ewma) ? (counts_q3 - hvStats.ewma) : (hvStats.ewma - counts_q3);
+	hvStats.warning = ((drift_abs*100u) > ((uint32_t)hvStats.ewma*RAD_HV_DRIFT_WARN_PCT))
+					|| ((dev*100u) > ((uint32_t)hvStats.ewma*RAD_HV_DEV_WARN_PCT));
+}
+
+// add raw counts of the last second to history, O(1) per call
+// running sums are updated by adding the new and subtracting the oldest value of each window
+static void UpdateHistory(uint16_t counts)
+{
+	for (byte i=0; i<RAD_SUM_NUM; i++)
+	{
+		byte old = secIdx + RAD_HIST_SIZE - secSumLen[i];
+		if (old >= RAD_HIST_SIZE) { old -= RAD_HIST_SIZE; }
+		secSums[i] += counts;
+		secSums[i] -= secHist[old];
+	}
+	secHist[secIdx] = counts;
+	if (++secIdx >= RAD_HIST_SIZE) { secIdx = 0; }
+	if (histSecs < 3600u) { histSecs++; }
+	
+	// completed blocks are shifted into the block rings
+	if (!(secIdx % 30u)) { PushBlock(blockHist30s, RAD_BLOCK_NUM_30S, &blockIdx30s, &sum10min, secSums[RAD_SUM_30S]); }
+	if (!secIdx) { PushBlock(blockHist1min, RAD_BLOCK_NUM_1MIN, &blockIdx1min, &sum1h, secSums[RAD_SUM_1MIN]); }
+}
+
+// store block sum in ring & update running sum of the ring
+// escaped values lose resolution, running sum stays consistent because the decoded values are added & subtracted
+static void PushBlock(uint16_t *hist, byte num, byte *idx, uint32_t *sum, uint32_t counts)
+{
+	uint16_t code = (counts < RAD_BLOCK_ESC) ? counts : (RAD_BLOCK_ESC | (counts >> RAD_BLOCK_ESC_SHIFT));
+	uint16_t old = hist[*idx];
+	
+	*sum += (code < RAD_BLOCK_ESC) ? code : ((uint32_t)(code & ~RAD_BLOCK_ESC) << RAD_BLOCK_ESC_SHIFT);
+	*sum -= (old < RAD_BLOCK_ESC) ? old : ((uint32_t)(old & ~RAD_BLOCK_ESC) << RAD_BLOCK_ESC_SHIFT);
+	hist[*idx] = code;
+	if (++(*idx) >= num) { *idx = 0; }
+}
+
+// check 1, 4 & 16s windows of raw counts, call this every second after UpdateHistory()
+static void CheckAlarmWindows(uint16_t counts)
+{
+	// limits depend on dead-time model
+	if (alarmModel != RAD_deadTimeModel) { RAD_SetAlarmLevel(alarmRate); }
+	
+	if (alarmLimits[1] && (counts >= alarmLimits[1])) { rateAlarm = true; }
+	if (alarmLimits[2] && (secSums[RAD_SUM_4S] >= alarmLimits[2])) { rateAlarm = true; }
+	if (alarmLimits[3] && (secSums[RAD_SUM_16S] >= alarmLimits[3])) { rateAlarm = true; }
+}
+
+// accumulate interval statistics for the dead-time calibration, finish once precise enough
+static void UpdateDeadTimeCal(uint32_t interval)
+{
+	// longer intervals are practically impossible at usable calibration rates
+	if (interval > UINT16_MAX) { return; }
+	
+	dtCalSum += interval;
+	dtCalSumSq += (uint32_t)interval*interval;
+	if ((++dtCalNum & RAD_DTCAL_CHECK_MASK) && (dtCalNum < RAD_DTCAL_MAX_NUM)) { return; }
+	
+	// standard error of mean - sd is about sd/sqrt(N)
+	float mean = (float)dtCalSum/dtCalNum;
+	float var = (float)dtCalSumSq/dtCalNum - mean*mean;
+	if (var < 0.0f) { var = 0.0f; }
+	bool precise = (var < (float)(RAD_DTCAL_MAX_ERR_US*RAD_DTCAL_MAX_ERR_US)*dtCalNum);
+	if (!(precise && (dtCalNum >= RAD_DTCAL_MIN_NUM)) && (dtCalNum < RAD_DTCAL_MAX_NUM)) { return; }
+	
+	// done
+	float dead_time = mean - sqrtf(var);
+	RAD_SetCapture(RAD_CAP_DTCAL, false);
+	
+	char dt_str[FMT_BUF_SIZE], err_str[FMT_BUF_SIZE];
+	FMT_FixedSigned(dt_str, (int32_t)floorf(dead_time*10.0f + 0.5f), 1, 1);
+	FMT_Fixed(err_str, (uint32_t)(sqrtf(var/dtCalNum)*10.0f + 0.5f), 1, 1);
+	UART_Printf("Dead time cal: %sus +-%sus n=%lu ", dt_str, err_str, dtCalNum);
+	if (precise && (dead_time > 0.0f) && RAD_SetDeadTime((uint16_t)(dead_time + 0.5f))) { UART_Printf("OK\n"); }
+	else { UART_Printf("FAILED\n"); }
+}
+
+// dead-time correction of Q8 CPS value with the selected model, result in Q8
+// table lookup with linear interpolation, non-paralyzable rates beyond the table are corrected with 1/(1-m*t)
+// rates no model can resolve set over_range (optional) & are corrected with the largest factor -> lower bound
+// integer & fractional part are handled separately to keep everything in 32bit
+static uint32_t CorrectDeadTime(uint32_t cps, bool *over_range)
+{
+	RAD_DeadTimeModel_t model = RAD_deadTimeModel;
+	uint32_t ci = cps >> 8, cf = cps & 0xFF;
+	uint32_t x = ((ci*deadTimeQ24) >> 8) + ((cf*deadTimeQ24) >> 16); // Q16; m*t
+	
+	uint16_t factor = deadTimeLut[model][RAD_DT_LUT_SIZE - 1];
+	bool over = false;
+	if (x >= deadTimeXMax[model])
+	{
+		// Q28/Q16 -> Q12, denominator >4096 keeps the factor below RAD_DT_FACTOR_MAX
+		if ((model == RAD_DT_NONPARALYZABLE) && (x < (65536ul - 4096u))) { factor = 268435456ul / (65536ul - x); }
+		else if (model == RAD_DT_NONPARALYZABLE) { factor = RAD_DT_FACTOR_MAX; over = true; }
+		else { over = true; }
+	}
+	else
+	{
+		// table position u = 1-sqrt(1-x/x_max) in Q15, 9bit fraction between entries
+		uint32_t r = (x*deadTimeScale[model]) >> 12;
+		if (r > UINT16_MAX) { r = UINT16_MAX; }
+		uint16_t u = 32768u - ISqrt((65536ul - r) << 14);
+		byte i = u >> 9;
+		uint16_t frac = u & 0x1FF;
+		factor = deadTimeLut[model][i] + (((uint32_t)(deadTimeLut[model][i+1] - deadTimeLut[model][i])*frac) >> 9);
+	}
+	
+	uint32_t corr = (ci*factor + ((cf*factor) >> 8) + 8u) >> 4;
+	if (corr >= RAD_RATE_MAX_Q8)
+	{
+		corr = RAD_RATE_MAX_Q8;
+		over = true;
+	}
+	
+	if (over_range != NULL) { *over_range = over; }
+	return corr;
+}
+
+// convert Q16 CPS to dose rate in nSv/h
+static uint32_t CpsToDoseRate(uint32_t cps)
+{
+	return (MulFrac(cps, RAD_RATE_SCALE_Q15) + 64) >> 7;
+}
+
+// smallest count k with P(N>=k) <= RAD_ALARM_P_FA for Poisson distributed N with given mean
+// exact tail sum for small means, normal approximation with skew correction otherwise (exact or +1 above 50)
+static uint16_t PoissonLimit(float mean)
+{
+	if (mean >= 64.0f)
+	{
+		float k = mean + RAD_ALARM_Z_FA*sqrtf(mean) + (RAD_ALARM_Z_FA*RAD_ALARM_Z_FA + 2.0f)/6.0f + 1.0f;
+		return (k < (float)UINT16_MAX) ? (uint16_t)k : UINT16_MAX;
+	}
+	
+	// go past the mode until probability is negligible, then sum up tail backwards until limit is exceeded
+	uint16_t k = 0;
+	float p = expf(-mean);
+	while ((k < mean) || (p > RAD_ALARM_P_FA*1.0e-3f))
+	{
+		k++;
+		p *= mean/k;
+	}
+	
+	float tail = 0.0f;
+	for (; k>0; k--)
+	{
+		tail += p;
+		if (tail > RAD_ALARM_P_FA) { break; }
+		p *= k/mean;
+	}
+	
+	return k + 1;
+}
+
+// integer square root, floor(sqrt(x))
+static uint16_t ISqrt(uint32_t x)
+{
+	uint32_t root = 0;
+	uint32_t bit = 1ul << 30;
+	while (bit > x) { bit >>= 2; }
+	
+	// one result bit per iteration
+	while (bit)
+	{
+		if (x >= (root + bit))
+		{
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else { root >>= 1; }
+		bit >>= 2;
+	}
+	
+	return (uint16_t)root;
 }
 
 // INT1 external interrupt ISR (GM tube pulse event)
@@ -265,6 +1362,84 @@ ISR(INT1_vect)
 	// increment raw pulse counter, max rate is ~5kcps / ~1.5mSv/h
 	// overflow is acceptable as long as counter never overflows twice before being handled by ProcessData()
 	rawCounts++;
+	
+	// quarter second alarm window, restart count if window changed
+	// TCNT2 reads the value from before sleep until the next TOSC1 edge after wake-up (~30us)
+	// such a pulse is counted in the window of the preceding wake-up, the count statistics are not affected
+	byte window = TCNT2 >> RAD_ALARM_WIN_SHIFT;
+	if (window != alarmWindow)
+	{
+		alarmWindow = window;
+		alarmCounts = 0;
+	}
+	if (++alarmCounts == alarmLimits[0])
+	{
+		rateAlarm = true;
+		SYS_SET_EVENT(SYS_EVT_RATE_ALARM);
+	}
+	
+	// capture timestamp, ~60 cycles incl. ISR overhead, ~100 cycles with interval histogram (2% load at 5kCPS)
+	if (captureEnable)
+	{
+		uint16_t lo = TCNT1;
+		uint16_t hi = t1Overflows;
+		
+		// overflow happened but T1 OVF ISR was not executed yet
+		if (GET(TIFR1, TOV1) && (lo < 0x8000)) { hi++; }
+		
+		uint32_t timestamp = ((uint32_t)hi << 16) | lo;
+		
+		// interval histogram, bounded time: pick the byte holding the msb, look up its half-octave, ~40 cycles
+		// counted even if buffer is full
+		if (histValid)
+		{
+			uint32_t interval = timestamp - histStamp;
+			uint16_t w;
+			byte base;
+			if (interval >> 24) { w = interval >> 16; base = 32u; }
+			else if (interval >> 16) { w = interval >> 8; base = 16u; }
+			else { w = interval; base = 0u; }
+			
+			// w >= 256 unless interval < 256us; if high byte is 1, next bit is in the low byte
+			byte b = w >> 8;
+			byte idx;
+			if (!b) { idx = halfOctaveLut[(byte)w]; }
+			else if (b == 1) { idx = base + 16u + (((byte)w) >> 7); }
+			else { idx = base + 16u + halfOctaveLut[b]; }
+			
+			// clamp to histogram range, first & last bin collect everything outside
+			idx = (idx < RAD_IHIST_BIN_MIN) ? 0 : (idx - RAD_IHIST_BIN_MIN + 1);
+			if (idx >= RAD_IHIST_NUM) { idx = RAD_IHIST_NUM - 1; }
+			if (intervalHist[idx] != UINT16_MAX) { intervalHist[idx]++; }
+		}
+		histStamp = timestamp;
+		histValid = true;
+		
+		byte next = (pulseBufIn + 1) & (RAD_PULSE_BUF_SIZE - 1);
+		if (next == pulseBufOut)
+		{
+			// buffer full
+			pulseDrops++;
+			pulseGap = true;
+		}
+		else
+		{
+			if (pulseGap)
+			{
+				pulseGaps |= 1ul << pulseBufIn;
+				pulseGap = false;
+			}
+			pulseBuffer[pulseBufIn] = timestamp;
+			pulseBufIn = next;
+			SYS_SET_EVENT(SYS_EVT_PULSES);
+		}
+	}
+}
+
+// T1 overflow ISR, extends pulse timestamps to 32bit, only enabled during capture
+ISR(TIMER1_OVF_vect)
+{
+	t1Overflows++;
 }
 
 // HV supply monitor pin change ISR; enabled: PCINT12
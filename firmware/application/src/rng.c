@@ -0,0 +1,350 @@
+/*
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Implementation of the GM tube random number generator & DRBG
+===============================================================================
+*/
+
+#include "rng.h"
+//---------------
+#include "rad.h"
+#include "uart.h"
+
+// internal defines
+// raw bits: two consecutive pulse intervals are compared, 1 if the first one is longer, ties are discarded
+// intervals are i.i.d. exponential (dead time shifts both equally) -> fair coin, von Neumann removes residual bias
+// health tests as in NIST SP 800-90B 4.4 on the raw bits, claimed min-entropy 0.8 bit, false alarm rate 2^-20
+#define RNG_RCT_CUTOFF		26u		// repetition count test: 1 + ceil(20/H) equal bits in a row
+#define RNG_APT_WINDOW		1024u	// adaptive proportion test: binary window size
+#define RNG_APT_CUTOFF		664u	// 1 + CRITBINOM(1024, 2^-H, 1 - 2^-20)
+#define RNG_POOL_SIZE		64u		// debiased output bytes, must be a power of 2 & <=128
+#define RNG_BULK_LINE		32u		// bytes per hex line in bulk mode
+
+// DRBG: ChaCha20 (RFC 8439) with fast key erasure, key is replaced by keystream after every request & reseed
+// reseeded with 256 debiased bits as soon as the pool holds them -> every ~2048 pulses
+#define RNG_SEED_SIZE		32u
+#define RNG_RESEED_MAX_AGE	3600ul	// [s]; pulse capture is enabled for a reseed if the key is older, see RNG_Tick()
+#define RNG_FRAME_DATA		0x04u	// binary frame type of requested bytes, see tools/binlog_decode.py
+#define RNG_FRAME_LEN		(UART_FRAME_MAX - 1u)
+#define ROTL(x, n)			(((x) << (n)) | ((x) >> (32 - (n))))
+#define QR(a, b, c, d)		a += b; d ^= a; d = ROTL(d, 16); c += d; b ^= c; b = ROTL(b, 12); \
+							a += b; d ^= a; d = ROTL(d, 8); c += d; b ^= c; b = ROTL(b, 7)
+
+// internal variables
+static uint32_t pairInterval;		// first interval of a comparison
+static bool pairPending;
+static bool vnBit, vnPending;		// first raw bit of a von Neumann pair
+static bool rctBit, aptBit;
+static byte rctCount;
+static uint16_t aptCount, aptIdx;
+static bool rngReady;				// first APT window passed since boot or last failure
+static uint16_t rngFailures;
+static uint32_t rngRawBits;
+static byte rngPool[RNG_POOL_SIZE];
+static byte poolIn, poolOut;		// free running, masked on access
+static byte poolAccu, poolAccuBits;
+static bool bulkEnable;
+static uint32_t bulkBits, bulkTime;
+static uint32_t drbgKey[8];
+static uint32_t drbgCounter;		// block counter, restarts with every new key
+static uint32_t drbgBlock[16];		// keystream not handed out yet, ChaCha state while generating
+static byte drbgAvail;
+static bool drbgSeeded;
+static uint16_t drbgReseeds;
+static uint32_t drbgReseedAge;
+static uint16_t drbgPending;		// bytes of the current request not sent yet
+
+// internal function prototypes
+static bool HealthTest(bool bit);
+static void PutBit(bool bit);
+static void Reseed(void);
+static void Rekey(void);
+static void DrbgRead(byte *dst, byte len);
+static void ChaChaBlock(void);
+
+// feed a pulse interval [us] into the entropy pipeline, call this for every captured interval
+// intervals spanning dropped pulses must be left out, their distribution differs
+// 0.125 output bits per interval -> ~0.04 bit/s at background, ~125 bit/s at 1kCPS
+void RNG_AddInterval(uint32_t interval)
+{
+	if (!pairPending)
+	{
+		pairInterval = interval;
+		pairPending = true;
+		return;
+	}
+	pairPending = false;
+	if (interval == pairInterval) { return; }
+	
+	bool bit = (pairInterval > interval);
+	rngRawBits++;
+	if (!HealthTest(bit) || !rngReady) { return; }
+	
+	// von Neumann: 01 -> 0, 10 -> 1, 00 & 11 are discarded
+	if (!vnPending)
+	{
+		vnBit = bit;
+		vnPending = true;
+		return;
+	}
+	vnPending = false;
+	if (vnBit != bit) { PutBit(vnBit); }
+}
+
+// take random bytes from the pool, returns false if not enough entropy collected yet
+bool RNG_GetBytes(void *data, byte len)
+{
+	if ((byte)(poolIn - poolOut) < len) { return false; }
+	
+	byte *dst = data;
+	for (byte i=0; i<len; i++) { dst[i] = rngPool[poolOut++ & (RNG_POOL_SIZE - 1)]; }
+	return true;
+}
+
+// take random bytes from the DRBG, returns false until it got its first seed
+// cheap enough to be used for anything that needs unpredictable numbers, ~300 cycles per byte
+bool RNG_GetDrbgBytes(void *data, byte len)
+{
+	if (!drbgSeeded) { return false; }
+	
+	DrbgRead(data, len);
+	Rekey();
+	return true;
+}
+
+// send len DRBG bytes in binary frames, a new request replaces a running one, 0 cancels
+// returns false if the DRBG is not seeded yet
+bool RNG_Request(uint16_t len)
+{
+	if (!drbgSeeded) { return false; }
+	
+	drbgPending = len;
+	if (!len) { Rekey(); }
+	RNG_ProcessRequest();
+	return true;
+}
+
+// queue frames of a running request until the TX buffer is full, call this when TX buffer ran low
+// link is the limit: ~2.6kB/s at 28.8kBd incl. framing, generation takes <15% CPU at that rate
+void RNG_ProcessRequest(void)
+{
+	while (drbgPending)
+	{
+		// keystream is only generated for frames that fit, nothing has to be kept until the next call
+		byte len = (drbgPending < RNG_FRAME_LEN) ? drbgPending : RNG_FRAME_LEN;
+		if (!UART_FrameFits(len + 1u)) { return; }
+		
+		byte frame[UART_FRAME_MAX];
+		frame[0] = RNG_FRAME_DATA;
+		DrbgRead(&frame[1], len);
+		drbgPending -= len;
+		if (!drbgPending) { Rekey(); } // request done, old keystream must not be recoverable
+		UART_SendFrame(frame, len + 1u);
+	}
+}
+
+// bulk mode: pool is sent as hex lines every second, enables pulse capture until stopped
+// throughput is limited by the pool size to 512 bit/s
+void RNG_SetBulk(bool enable)
+{
+	if (enable == bulkEnable) { return; } // nothing to do
+	
+	RAD_SetCapture(RAD_CAP_BULK, enable);
+	if (enable)
+	{
+		bulkBits = 0;
+		bulkTime = 0;
+	}
+	
+	bulkEnable = enable;
+}
+
+// returns true if bulk mode is active
+bool RNG_GetBulk(void)
+{
+	return bulkEnable;
+}
+
+// collect a DRBG seed & send collected bytes in bulk mode, call this every second
+void RNG_Tick(void)
+{
+	if (drbgSeeded) { drbgReseedAge++; }
+	
+	// entropy needs pulse capture, which keeps the CPU in idle sleep -> only on USB power, i.e. while UART is enabled
+	// DRBG output only leaves via UART anyway, bulk mode gets the pool exclusively
+	bool seed = UART_GetEnabled() && !bulkEnable && (!drbgSeeded || (drbgReseedAge >= RNG_RESEED_MAX_AGE));
+	RAD_SetCapture(RAD_CAP_SEED, seed);
+	
+	if (!bulkEnable) { return; }
+	bulkTime++;
+	
+	char line[2*RNG_BULK_LINE + 1];
+	byte len = 0;
+	while (poolIn != poolOut)
+	{
+		byte data = rngPool[poolOut++ & (RNG_POOL_SIZE - 1)];
+		line[len++] = "0123456789abcdef"[data >> 4];
+		line[len++] = "0123456789abcdef"[data & 0x0F];
+		bulkBits += 8;
+		
+		if ((len == 2*RNG_BULK_LINE) || (poolIn == poolOut))
+		{
+			line[len] = 0;
+			UART_Printf("%s\n", line);
+			len = 0;
+		}
+	}
+}
+
+// get pipeline & bulk mode statistics
+RNG_Stats_t RNG_GetStats(void)
+{
+	RNG_Stats_t stats;
+	stats.rawBits = rngRawBits;
+	stats.bits = bulkBits;
+	stats.time = bulkTime;
+	stats.failures = rngFailures;
+	stats.pool = poolIn - poolOut;
+	stats.ready = rngReady;
+	stats.seeded = drbgSeeded;
+	stats.reseeds = drbgReseeds;
+	stats.reseedAge = drbgReseedAge;
+	stats.pending = drbgPending;
+	
+	return stats;
+}
+
+// continuous health tests, returns false & restarts the startup test on failure
+static bool HealthTest(bool bit)
+{
+	bool ok = true;
+	
+	// repetition count test
+	if (rctCount && (bit == rctBit))
+	{
+		if (++rctCount >= RNG_RCT_CUTOFF) { ok = false; }
+	}
+	else
+	{
+		rctBit = bit;
+		rctCount = 1;
+	}
+	
+	// adaptive proportion test, counts occurrences of the first bit of each window
+	if (!aptIdx)
+	{
+		aptBit = bit;
+		aptCount = 0;
+	}
+	if ((bit == aptBit) && (++aptCount >= RNG_APT_CUTOFF)) { ok = false; }
+	if (++aptIdx == RNG_APT_WINDOW)
+	{
+		aptIdx = 0;
+		if (ok) { rngReady = true; } // startup test: one complete window without failure
+	}
+	
+	if (ok) { return true; }
+	
+	// discard everything that might be affected, output resumes after the next good window
+	if (rngReady) { UART_Printf("RNG health test failed!\n"); }
+	rngFailures++;
+	rngReady = false;
+	rctCount = 0;
+	aptIdx = 0;
+	vnPending = false;
+	poolAccuBits = 0;
+	poolOut = poolIn;
+	return false;
+}
+
+// collect debiased bits into bytes, pool drops new bytes when full
+static void PutBit(bool bit)
+{
+	poolAccu = (poolAccu << 1) | bit;
+	if (++poolAccuBits < 8) { return; }
+	poolAccuBits = 0;
+	
+	if ((byte)(poolIn - poolOut) < RNG_POOL_SIZE) { rngPool[poolIn++ & (RNG_POOL_SIZE - 1)] = poolAccu; }
+	
+	// bulk mode is for testing the raw entropy, it gets the pool exclusively
+	if (!bulkEnable && ((byte)(poolIn - poolOut) >= RNG_SEED_SIZE)) { Reseed(); }
+}
+
+// mix a full seed into the key, keystream of the old key becomes unrelated
+static void Reseed(void)
+{
+	byte *key = (byte*)drbgKey;
+	for (byte i=0; i<RNG_SEED_SIZE; i++) { key[i] ^= rngPool[poolOut++ & (RNG_POOL_SIZE - 1)]; }
+	drbgCounter = 0;
+	Rekey();
+	
+	drbgSeeded = true;
+	drbgReseeds++;
+	drbgReseedAge = 0;
+}
+
+// fast key erasure: next keystream block replaces the key, buffered keystream is discarded
+static void Rekey(void)
+{
+	ChaChaBlock();
+	memcpy(drbgKey, drbgBlock, sizeof(drbgKey));
+	memset(drbgBlock, 0, sizeof(drbgBlock));
+	drbgCounter = 0;
+	drbgAvail = 0;
+}
+
+// copy keystream bytes, generates new blocks as needed
+static void DrbgRead(byte *dst, byte len)
+{
+	while (len)
+	{
+		if (!drbgAvail)
+		{
+			ChaChaBlock();
+			drbgAvail = sizeof(drbgBlock);
+		}
+		
+		byte *src = (byte*)drbgBlock + sizeof(drbgBlock) - drbgAvail;
+		byte n = (len < drbgAvail) ? len : drbgAvail;
+		memcpy(dst, src, n);
+		memset(src, 0, n);
+		drbgAvail -= n;
+		dst += n;
+		len -= n;
+	}
+}
+
+// ChaCha20 block function into drbgBlock, zero nonce, little endian like the AVR itself
+// works in place, feed forward input is rebuilt from sigma, key & counter -> no state on the stack
+// estimated ~20k cycles per 64 byte block with avr-gcc -Os (2.5ms at 8MHz)
+static void ChaChaBlock(void)
+{
+	static const __flash uint32_t sigma[4] = {0x61707865ul, 0x3320646Eul, 0x79622D32ul, 0x6B206574ul}; // "expand 32-byte k"
+	uint32_t *x = drbgBlock;
+	for (byte i=0; i<4; i++) { x[i] = sigma[i]; }
+	memcpy(&x[4], drbgKey, sizeof(drbgKey));
+	x[12] = drbgCounter;
+	x[13] = x[14] = x[15] = 0;
+	
+	for (byte i=0; i<10; i++)
+	{
+		// column round
+		QR(x[0], x[4], x[8], x[12]);
+		QR(x[1], x[5], x[9], x[13]);
+		QR(x[2], x[6], x[10], x[14]);
+		QR(x[3], x[7], x[11], x[15]);
+		// diagonal round
+		QR(x[0], x[5], x[10], x[15]);
+		QR(x[1], x[6], x[11], x[12]);
+		QR(x[2], x[7], x[8], x[13]);
+		QR(x[3], x[4], x[9], x[14]);
+	}
+	for (byte i=0; i<4; i++) { x[i] += sigma[i]; }
+	for (byte i=0; i<8; i++) { x[4 + i] += drbgKey[i]; }
+	x[12] += drbgCounter++;
+}
+
+// -------------------------------------- EOF --------------------------------------
@@ -14,7 +14,6 @@
 #include "uart.h"
 
 // internal variables
-static bool secTickFlag;			// auxiliary T2 overflow flag, set by T2 OVF ISR
 static volatile uint32_t rtcUptime;	// uptime in sec, incremented by T2 OVF ISR
 static int32_t rtcOffset;			// offset to match set system time to uptime
 
@@ -37,7 +36,6 @@ bool RTC_InitRtc(void)
 		if (GET(TIFR2, TOV2))
 		{
 			CLR_FLAG(TIFR2, TOV2);	// clear overflow flag
-			secTickFlag = false;	// clear auxiliary overflow flag
 			SET(TIMSK2, TOIE2);		// enable T2 overflow interrupt
 			return true;			// T2 init successful
 		}
@@ -79,7 +77,7 @@ uint32_t RTC_GetRcOscFreq(void)
 	ret = 256 * (uint32_t)TCNT1;	// calculate RC oscillator frequency
 	TCCR1B = t1_conf;				// restore T1 settings
 	rtcUptime += 2;					// preserve uptime integrity
-	secTickFlag = true;				// set auxiliary flag
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { SYS_SET_EVENT(SYS_EVT_SEC_TICK); } // catch up on missed sec tick
 
 	return ret;
 }
@@ -110,18 +108,6 @@ RTC_Time_t RTC_GetSysTime(void)
 	return CalcSysTime(RTC_GetSecTime());
 }
 
-// returns true if one second mark expired
-bool RTC_CheckSecTick(void)
-{
-	if (secTickFlag)
-	{
-		secTickFlag = false;
-		return true;
-	}
-	
-	return false;
-}
-
 // calculate systime in h:m:s format from raw seconds
 static RTC_Time_t CalcSysTime(int32_t secs)
 {
@@ -144,7 +130,7 @@ ISR(TIMER2_OVF_vect)
 {
 	// increment raw second counter
 	rtcUptime++;
-	secTickFlag = true;
+	SYS_SET_EVENT(SYS_EVT_SEC_TICK);
 	
 	// save copy of raw counter variable
 	RAD_UpdateBuffer();
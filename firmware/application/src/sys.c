@@ -13,6 +13,24 @@
 #include "gpio.h"
 #include "pwr.h"
 
+// externally visible variables
+volatile byte SYS_pendingEvents;	// SYS_Event_t bits
+
+// return & clear all pending events
+byte SYS_GetEvents(void)
+{
+	byte events;
+	
+	// avoid event being set by ISR in between
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		events = SYS_pendingEvents;
+		SYS_pendingEvents = 0;
+	}
+	
+	return events;
+}
+
 // handle critical fault
 void SYS_Assert(bool ok)
 {
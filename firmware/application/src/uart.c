@@ -11,11 +11,13 @@
 #include "uart.h"
 //---------------
 #include "../../shared/defs.h"
+#include "eep.h"
 #include "gpio.h"
 #include "rtc.h"
 
 // internal variables
-static bool uartBusy, uartEnable, rxFrameError;
+static volatile bool uartBusy;		// cleared by TX complete ISR
+static bool uartEnable, rxFrameError;
 static volatile byte txBuffer[UART_TX_BUF_SIZE], rxBuffer[UART_RX_BUF_SIZE]; // ring buffers
 static volatile byte rxBufIn, rxBufOut, txBufIn, txBufOut;
 
@@ -30,8 +32,8 @@ bool UART_Init(void)
 	UCSR0D |= BV(RXS)|BV(SFDE);	// clear & enable start frame detection on RXS to wake up on RX
 
 	// read UBRR value from EEPROM & apply if valid
-	while (!eeprom_is_ready());
-	byte ubrr = eeprom_read_byte(BOOT_UBRR_EEP_ADDR);
+	byte ubrr;
+	EEP_Read((uint16_t)BOOT_UBRR_EEP_ADDR, &ubrr, sizeof(ubrr));
 
 	// otherwise load default value
 	if (!UART_SetUbrr(ubrr, false))
@@ -66,8 +68,8 @@ void UART_Enable(bool en)
 	}
 }
 
-// send formatted string via UART
-void UART_Printf(const char *formatstr, ...)
+// send formatted string via UART, format string in flash, use UART_Printf() for literals
+void UART_PrintfP(const char *formatstr, ...)
 {
 	// complete current transmission but don't accept new input
 	if (!uartEnable) { return; }
@@ -77,13 +79,65 @@ void UART_Printf(const char *formatstr, ...)
 	va_list args;
 	va_start(args, formatstr);
 	static FILE uart_stream = FDEV_SETUP_STREAM(UartPutChar, NULL, _FDEV_SETUP_WRITE);
-	vfprintf(&uart_stream, formatstr, args);
+	vfprintf_P(&uart_stream, formatstr, args);
 	va_end(args);
 
 	SET(UCSR0A, TXC0);		// clear transmit complete flag
 	SET(UCSR0B, UDRIE0);	// enable data register empty interrupt
 }
 
+// returns true if a frame with len bytes payload would be sent by UART_SendFrame() now
+// ISR only frees space, so the result holds until the main loop queues something else
+bool UART_FrameFits(byte len)
+{
+	if (!uartEnable || (len > UART_FRAME_MAX)) { return false; }
+	
+	// encoded frame is at most payload, CRC, one COBS code & delimiter
+	byte used = txBufIn - txBufOut; // overflow is intentional, buffer size is 256
+	return (((uint16_t)used + len + 4u + UART_PRINT_BUF_SIZE) <= (UART_TX_BUF_SIZE - 1u));
+}
+
+// send binary frame: payload & CRC-CCITT, COBS encoded & terminated by 0x00 -> receiver resyncs on any zero byte
+// frame is dropped if it doesn't fit into the TX buffer, never blocks
+// UART_PRINT_BUF_SIZE bytes are left free, so bulk frames don't make text output wait in UartPutChar()
+bool UART_SendFrame(const byte *data, byte len)
+{
+	if (!UART_FrameFits(len)) { return false; }
+	
+	// payload & CRC (little endian) are COBS encoded straight into the TX buffer, no copy on the stack
+	// every zero is replaced by the distance to the next one, block length <255 for this frame size
+	// ISR only sends up to txBufIn, so the frame becomes visible when it's complete; indices wrap with the buffer
+	uint16_t crc = 0xFFFF;
+	byte code_idx = txBufIn, idx = code_idx + 1;
+	for (byte i=0; i<(len + 2u); i++)
+	{
+		byte c;
+		if (i < len)
+		{
+			c = data[i];
+			crc = _crc_ccitt_update(crc, c);
+		}
+		else { c = (i == len) ? (crc & 0xFF) : (crc >> 8); }
+		
+		if (c)
+		{
+			txBuffer[idx++] = c;
+			continue;
+		}
+		txBuffer[code_idx] = idx - code_idx;
+		code_idx = idx++;
+	}
+	txBuffer[code_idx] = idx - code_idx;
+	txBuffer[idx++] = 0; // delimiter
+	
+	uartBusy = true;
+	txBufIn = idx;
+	
+	SET(UCSR0A, TXC0);		// clear transmit complete flag
+	SET(UCSR0B, UDRIE0);	// enable data register empty interrupt
+	return true;
+}
+
 // read LF-terminated string from RX input buffer
 bool UART_RxString(char* buffer)
 {
@@ -143,6 +197,16 @@ bool UART_TxBusy(void)
 	return false;
 }
 
+// prepare sleep while UART is transmitting, call this with interrupts disabled
+// returns true if TX is busy -> I/O clock must keep running, TX complete interrupt wakes us up when done
+bool UART_TxSleep(void)
+{
+	if (!UART_TxBusy()) { return false; }
+	
+	SET(UCSR0B, TXCIE0);
+	return true;
+}
+
 // set UBRR register
 bool UART_SetUbrr(byte ubrr, bool write_to_eep)
 {
@@ -156,8 +220,7 @@ bool UART_SetUbrr(byte ubrr, bool write_to_eep)
 		if (write_to_eep)
 		{
 			// write UBRR value to EEPROM for bootloader & first UART_Init()
-			while (!eeprom_is_ready());
-			eeprom_update_byte(BOOT_UBRR_EEP_ADDR, ubrr);
+			EEP_Write((uint16_t)BOOT_UBRR_EEP_ADDR, &ubrr, sizeof(ubrr));
 		}
 		return true;
 	}
@@ -198,9 +261,12 @@ bool UART_GetEnabled(void)
 }
 
 // write single char to TX buffer
+// full buffer -> wait for the ISR to free a slot instead of overwriting queued output, ~350us per char
+// bounded by the buffer size, i.e. <90ms even if prints of several wake-ups stack up behind bulk frames
 static int UartPutChar(char c, FILE *stream)
 {
 	(void)stream;
+	while ((byte)(txBufIn + 1u) == txBufOut) { SET(UCSR0B, UDRIE0); }
 	txBuffer[txBufIn++] = c;
 	txBufIn %= UART_TX_BUF_SIZE;	// wrap around
 	return 0;
@@ -213,16 +279,32 @@ ISR(USART0_UDRE_vect)
 	UDR0 = txBuffer[txBufOut++];	// write data byte to UART from TX buffer, this clears UDRE flag
 	txBufOut %= UART_TX_BUF_SIZE;	// ring buffer wrap around
 	
+	// let bulk senders refill before the line goes idle
+	byte used = txBufIn - txBufOut; // overflow is intentional, buffer size is 256
+	if (used == UART_TX_LOW_WATER) { SYS_SET_EVENT(SYS_EVT_UART_TX); }
+	
 	// buffer empty -> disable data register empty interrupt, otherwise it will keep triggering
 	if (txBufOut == txBufIn) { CLR(UCSR0B, UDRIE0); }
 }
 
+// TX complete interrupt, only enabled by UART_TxSleep() to end idle sleep
+// executing this clears TXC flag -> transmission is done unless new data is already queued
+ISR(USART0_TX_vect)
+{
+	CLR(UCSR0B, TXCIE0);
+	if (!GET(UCSR0B, UDRIE0)) { uartBusy = false; }
+}
+
 // RX Interrupt
 ISR(USART0_RX_vect)
 {		
 	rxFrameError = GET(UCSR0A, FE0);	// get frame error flag
-	rxBuffer[rxBufIn++] = UDR0;			// read data byte from UART into RX buffer, this clears RXC flag
+	byte c = UDR0;						// read data byte from UART, this clears RXC flag
+	rxBuffer[rxBufIn++] = c;			// write into RX buffer
 	rxBufIn %= UART_RX_BUF_SIZE;		// ring buffer wrap around
+	
+	// wake up main loop only if there is something to parse
+	if ((c == '\n') || rxFrameError) { SYS_SET_EVENT(SYS_EVT_UART_RX); }
 }
 
 // -------------------------------------- EOF --------------------------------------
\ No newline at end of file
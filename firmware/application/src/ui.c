@@ -11,6 +11,7 @@
 #include "ui.h"
 //---------------
 #include "adc.h"
+#include "fmt.h"
 #include "gpio.h"
 #include "keys.h"
 #include "lcd.h"
@@ -22,7 +23,9 @@
 // internal defines
 #define UI_SOUND_DISABLE		0	// 0=default, 1=disable beeper
 #define UI_BAT_WARN_INTERVAL	5u	// [s]; time between beeps for low battery warning
+#define UI_HV_WARN_INTERVAL		60u	// [s]; time between beeps for HV converter drift warning
 #define UI_VBAT_UNDEFINED		-1	// valid battery voltage values are positive
+#define UI_ALARM_HOLD			10u	// [s]; rate alarm from count windows stays active at least this long
 
 // externally visible variables
 const float UI_alarmLvls[UI_ALARM_LVL_NUM] = {0.5f, 1.0f, 2.0f, 5.0f, 0.0f}; // alarm levels in Sv/h
@@ -31,8 +34,14 @@ UI_viewMode_t UI_viewMode;
 float UI_alarmLevel;
 
 // internal variables
-static byte batSymbol, filterLevel;
+static byte batSymbol;
+static RAD_AvgWindow_t avgWindow;
 static bool alarmAck, keyLock, alarmEn, batLow;
+static uint32_t alarmHoldEnd;	// uptime until rate alarm from count windows is held
+
+// internal function prototypes
+static void PrintDoseRate(uint32_t rate);
+static byte GetFilterLevel(void);
 
 // initialize user interface
 void UI_Init(void)
@@ -68,9 +77,16 @@ void UI_HandleKeys(byte key)
 			{
 				case UI_VIEW_DOSE_RATE:
 				{
-					// cycle through dose rate filter setting
-					if (++filterLevel >= RAD_FILTER_LVL_NUM) { filterLevel = 0; }
-					RAD_filterFactor = RAD_filterLvls[filterLevel];
+					// cycle through dose rate filter setting, custom factor continues with the fast one
+					byte level = GetFilterLevel() + 1;
+					if (level >= RAD_FILTER_LVL_NUM) { level = 0; }
+					RAD_filterFactor = RAD_filterLvls[level];
+					break;
+				}
+				case UI_VIEW_AVERAGE:
+				{
+					// cycle through averaging windows
+					if (++avgWindow >= RAD_AVG_NUM) { avgWindow = 0; }
 					break;
 				}
 				case UI_VIEW_ALARM:
@@ -84,7 +100,7 @@ void UI_HandleKeys(byte key)
 				case UI_VIEW_TOTAL_DOSE:
 				{
 					// reset total accumulated dose
-					RAD_SetTotalDose(0.0f);
+					RAD_SetTotalDose(0);
 					break;
 				}
 				case UI_VIEW_TIME:
@@ -95,8 +111,6 @@ void UI_HandleKeys(byte key)
 				}
 				default: { break; }
 			}
-			
-			LCD_Clear();
 			break;
 		}
 		case KEY_YEL_SHORT:
@@ -104,14 +118,12 @@ void UI_HandleKeys(byte key)
 			// toggle clicker
 			UI_clickEnable ^= true;
 			GPIO_SetPin(PIN_CLICK_EN, UI_clickEnable);
-			LCD_Clear();
 			break;
 		}
 		case KEY_YEL_LONG:
 		{
 			// toggle key lock
 			keyLock ^= true;
-			LCD_Clear();
 			break;
 		}
 		case KEY_RED_SHORT:
@@ -180,6 +192,7 @@ void UI_UpdateBattery(void)
 				LCD_Clear();
 				LCD_Printf(1, "BATTERY EMPTY!");
 				LCD_Printf(2, "Vbat=%u", vBat);
+				LCD_Flush();
 				_delay_ms(1000);
 				PWR_Shutdown();
 			}
@@ -190,8 +203,17 @@ void UI_UpdateBattery(void)
 // call this every second
 void UI_CheckAlarm(void)
 {
-	float rate = RAD_GetDoseRate();
+	static uint32_t level_old;
+	uint32_t rate = RAD_GetDoseRate();
+	uint32_t level = (UI_alarmLevel > 0.0f) ? (uint32_t)(UI_alarmLevel*1000.0f) : 0;
 	RTC_Time_t time = RTC_GetSysTime();
+	
+	// update count limits of rate alarm windows
+	if (level != level_old)
+	{
+		RAD_SetAlarmLevel(level);
+		level_old = level;
+	}
 
 	// check for alarm conditions
 	if (RAD_GetFault())
@@ -209,12 +231,15 @@ void UI_CheckAlarm(void)
 	}
 	else
 	{
-		alarmEn = (UI_alarmLevel != 0.0f) && (rate > UI_alarmLevel);
+		// smoothed dose rate or raw count windows above alarm level
+		alarmEn = level && ((rate > level) || (RTC_GetUpTime() < alarmHoldEnd));
 		if (alarmEn)
 		{
 			// dose rate alarm
+			char rate_str[FMT_BUF_SIZE];
+			FMT_Fixed(rate_str, rate, 3, 3);
 			UART_Printf("%02u:%02u:%02u ", time.hours, time.mins, time.secs);
-			UART_Printf("Dose Rate Alert! %.3fuSv/h\n", (double)rate);
+			UART_Printf("Dose Rate Alert! %suSv/h\n", rate_str);
 
 			if (alarmAck) { GPIO_SetPin(PIN_BEEP_EN, false); }
 			else
@@ -226,7 +251,6 @@ void UI_CheckAlarm(void)
 		else
 		{
 			// reset alarm
-			LCD_Clear();
 			GPIO_SetPin(PIN_BEEP_EN, false);
 			alarmAck = false;
 			alarmEn = false;
@@ -235,21 +259,35 @@ void UI_CheckAlarm(void)
 	
 	// emit periodic low battery warning
 	if (batLow && !(RTC_GetUpTime()%UI_BAT_WARN_INTERVAL)) { UI_EmitBeep(10); }
+	
+	// emit periodic HV converter warning, before it actually fails
+	if (RAD_GetHvStats().warning && !(RTC_GetUpTime()%UI_HV_WARN_INTERVAL)) { UI_EmitBeep(10); }
+}
+
+// call this if raw count windows exceeded the alarm level
+// alarm is triggered immediately, independent of the dose rate filter setting
+void UI_RateAlarm(void)
+{
+	bool active = alarmEn;
+	alarmHoldEnd = RTC_GetUpTime() + UI_ALARM_HOLD;
+	
+	// don't mess with beeper toggling of an active alarm
+	if (!active)
+	{
+		UI_CheckAlarm();
+		UI_RenderLcd();
+	}
 }
 
 // call this if display needs to be updated
 void UI_RenderLcd(void)
 {
-	float rate = RAD_GetDoseRate();
+	uint32_t rate = RAD_GetDoseRate();
 	RTC_Time_t time = RTC_GetSysTime();
+	char str[FMT_BUF_SIZE];
 	
-	// clearing screen produces visible delay -> only if screen changes
-	static int8_t old_view = UI_NUM_VIEW_MODES; // force update on first run
-	if (UI_viewMode != old_view)
-	{
-		LCD_Clear();
-		old_view = UI_viewMode;
-	}
+	// render whole screen into frame buffer, only changed cells are sent to the display
+	LCD_Clear();
 	
 	// handle view modes
 	switch (UI_viewMode)
@@ -257,44 +295,54 @@ void UI_RenderLcd(void)
 		case UI_VIEW_DOSE_RATE: // current dose rate
 		{
 			LCD_Printf(1, "Dose Rate:");
-			
-			if (rate < 10.0f)		 { LCD_Printf(2, "%.3fuSv/h",(double)rate); }
-			else if (rate < 100.0f)	 { LCD_Printf(2, "%.2fuSv/h",(double)rate); }
-			else if (rate < 1000.0f) { LCD_Printf(2, "%.1fuSv/h",(double)rate); }
-			else /* >1000 */		 { LCD_Printf(2, "%.2fmSv/h",(double)rate/1000); }
+			PrintDoseRate(rate);
 
-			// display alarm status
+			// display over-range, alarm status or 95% confidence interval
 			LCD_Position(2, 11);
-			if (alarmEn) { LCD_Printf(0, " !!!"); }
+			if (RAD_GetOverRange()) { LCD_Printf(0, " >MAX"); }
+			else if (alarmEn) { LCD_Printf(0, " !!! "); }
+			else { LCD_Printf(0, "+-%2u%%", RAD_GetDoseRateErr()); }
+			
+			break;
+		}
+		case UI_VIEW_AVERAGE: // boxcar average dose rate
+		{
+			static const __flash char avg_names[RAD_AVG_NUM][6] = {"10s", "1min", "10min", "1h"};
+			LCD_Printf(1, "Avg %S:", avg_names[avgWindow]);
+			
+			uint32_t avg;
+			if (RAD_GetAvgDoseRate(avgWindow, &avg)) { PrintDoseRate(avg); }
+			else { LCD_Printf(2, "--"); }
 			
 			break;
 		}
 		case UI_VIEW_TOTAL_DOSE: // total dose
 		{
 			LCD_Printf(1, "Total Dose:");
-			float dose = RAD_GetTotalDose();
-			
-			if (dose < 10.0f)		 { LCD_Printf(2, "%.3fuSv",(double)dose); }
-			else if (dose < 100.0f)	 { LCD_Printf(2, "%.2fuSv",(double)dose); }
-			else if (dose < 1000.0f) { LCD_Printf(2, "%.1fuSv",(double)dose); }
-			else /* >1000 */		 { LCD_Printf(2, "%.2fmSv",(double)dose/1000); }
+			FMT_Dose(str, RAD_GetTotalDose());
+			LCD_PrintStr(2, str);
 			
 			break;
 		}
 		case UI_VIEW_TIME: // system time
 		{
 			LCD_Printf(1, "Time:");
-			LCD_Printf(2, "%02u:%02u:%02u",time.hours,time.mins,time.secs);
+			FMT_Time(str, time.hours, time.mins, time.secs);
+			LCD_PrintStr(2, str);
 			
 			break;
 		}
 		case UI_VIEW_VOLTS: // voltages
 		{
-			double vs = ADC_GetVsys()/1000.0f;
-			double vb = ADC_GetVbat()/1000.0f;
-			
 			LCD_Printf(1, "Voltages:");
-			LCD_Printf(2, "Vs=%.2f Vb=%.2f", vs, vb);
+			
+			// mV -> V with 2 decimals
+			LCD_PrintStr(2, "Vs=");
+			FMT_Fixed(str, ADC_GetVsys(), 3, 2);
+			LCD_PrintStr(0, str);
+			LCD_PrintStr(0, " Vb=");
+			FMT_Fixed(str, ADC_GetVbat(), 3, 2);
+			LCD_PrintStr(0, str);
 			
 			break;
 		}
@@ -302,7 +350,12 @@ void UI_RenderLcd(void)
 		{
 			LCD_Printf(1, "Alarm Lvl:");
 
-			if (UI_alarmLevel) { LCD_Printf(2, "%.1fuSv/h", (double)UI_alarmLevel); }
+			if (UI_alarmLevel)
+			{
+				FMT_Fixed(str, (uint32_t)(UI_alarmLevel*10.0f + 0.5f), 1, 1);
+				LCD_PrintStr(2, str);
+				LCD_PrintStr(0, "uSv/h");
+			}
 			else { LCD_Printf(2, "Off"); }
 			
 			break;
@@ -329,12 +382,33 @@ void UI_RenderLcd(void)
 	// only display filter setting in dose rate mode
 	if (UI_viewMode == UI_VIEW_DOSE_RATE)
 	{
-		if (filterLevel == 0) { LCD_PrintChar(2, 16, 'F'); }
-		else if (filterLevel == 1) { LCD_PrintChar(2, 16, 'M'); }
-		else if (filterLevel == 2) { LCD_PrintChar(2, 16, 'S'); }
-		else { SYS_EXCEPTION(); }
+		// filter factor may also be set by command or restored from config
+		byte level = GetFilterLevel();
+		if (level == 0) { LCD_PrintChar(2, 16, 'F'); }
+		else if (level == 1) { LCD_PrintChar(2, 16, 'M'); }
+		else if (level == 2) { LCD_PrintChar(2, 16, 'S'); }
+		else if (level == 3) { LCD_PrintChar(2, 16, 'A'); }
+		else { LCD_PrintChar(2, 16, 'C'); } // custom
 	}
 	else { LCD_PrintChar(2, 16, ' '); }
+	
+	LCD_Flush();
+}
+
+// index of current filter factor in RAD_filterLvls, RAD_FILTER_LVL_NUM if it's a custom one
+static byte GetFilterLevel(void)
+{
+	byte level = 0;
+	while ((level < RAD_FILTER_LVL_NUM) && (RAD_filterLvls[level] != RAD_filterFactor)) { level++; }
+	return level;
+}
+
+// print dose rate [nSv/h] on 2nd line, precision & unit depend on value
+static void PrintDoseRate(uint32_t rate)
+{
+	char str[FMT_BUF_SIZE];
+	FMT_DoseRate(str, rate);
+	LCD_PrintStr(2, str);
 }
 
 // interrupt controlled beep emit
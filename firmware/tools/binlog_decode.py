@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Reference decoder for the binary UART log ('o1'), pulse stream ('p2') & DRBG bytes ('j')
+===============================================================================
+
+Frames are COBS encoded & terminated by 0x00, the last two decoded bytes are the CRC-CCITT
+(avr-libc _crc_ccitt_update, init 0xFFFF, little endian) of the payload. Payload types:
+  0x01 key	uptime u32 [s], counts u32, rate u32 [nSv/h], dose u32 [nSv]; little endian
+  0x02 delta	LEB128 varints: uptime delta, counts, zigzag rate delta, dose delta
+  0x03 pulses	capture drops u16, link drops u16, first timestamp u32 [us], varint intervals [us]
+  0x04 random	DRBG output bytes
+Counts are raw detector counts since the previous record, the first record after 'o1' counts from
+the moment logging was enabled. Delta records need a preceding key
+record, they are skipped until the next key record if a frame was lost or corrupted.
+Drop counters of pulse frames are cumulative, pulses lost in the capture buffer or because the
+UART could not keep up are reported on stderr. Timestamps are unwrapped across the 71min T1 wrap.
+ASCII lines between frames (command replies, messages) are passed through to stderr.
+
+usage: python3 binlog_decode.py [-p|-r] <file or serial device>, '-' reads stdin
+output: CSV with uptime [s], counts, rate [uSv/h], dose [uSv]
+		with -p: pulse timestamps [us], one per line
+		with -r: random bytes, binary; corrupted frames are missing
+"""
+
+import sys
+
+LOG_KEY		= 0x01
+LOG_DELTA	= 0x02
+LOG_PULSES	= 0x03
+LOG_RANDOM	= 0x04
+
+def crc_ccitt_update(crc, data):
+	data ^= crc & 0xFF
+	data = (data ^ (data << 4)) & 0xFF
+	return (((data << 8) | (crc >> 8)) ^ (data >> 4) ^ (data << 3)) & 0xFFFF
+
+def cobs_decode(enc):
+	# frames are shorter than 254 bytes, so every code is followed by a zero
+	out = bytearray()
+	i = 0
+	while i < len(enc):
+		code = enc[i]
+		if code == 0 or i + code > len(enc):
+			raise ValueError("bad COBS code")
+		out += enc[i + 1:i + code]
+		i += code
+		if i < len(enc):
+			out.append(0)
+	return bytes(out)
+
+def check_frame(enc):
+	raw = cobs_decode(enc)
+	if len(raw) < 3:
+		raise ValueError("short frame")
+	payload, crc = raw[:-2], raw[-2] | (raw[-1] << 8)
+	c = 0xFFFF
+	for b in payload:
+		c = crc_ccitt_update(c, b)
+	if c != crc:
+		raise ValueError("CRC error")
+	return payload
+
+def get_varint(buf, i):
+	value, shift = 0, 0
+	while True:
+		b = buf[i]
+		i += 1
+		value |= (b & 0x7F) << shift
+		shift += 7
+		if not b & 0x80:
+			return value, i
+
+class LogDecoder:
+	def __init__(self):
+		self.ref = None # uptime, rate, dose of previous record
+
+	def decode(self, payload):
+		t = payload[0]
+		if t == LOG_KEY and len(payload) == 17:
+			uptime = int.from_bytes(payload[1:5], "little")
+			counts = int.from_bytes(payload[5:9], "little")
+			rate = int.from_bytes(payload[9:13], "little")
+			dose = int.from_bytes(payload[13:17], "little")
+		elif t == LOG_DELTA:
+			if self.ref is None:
+				return None
+			i = 1
+			dt, i = get_varint(payload, i)
+			counts, i = get_varint(payload, i)
+			zz, i = get_varint(payload, i)
+			dd, i = get_varint(payload, i)
+			uptime = (self.ref[0] + dt) & 0xFFFFFFFF
+			rate = (self.ref[1] + ((zz >> 1) ^ -(zz & 1))) & 0xFFFFFFFF
+			dose = (self.ref[2] + dd) & 0xFFFFFFFF
+		else:
+			return None
+		self.ref = (uptime, rate, dose)
+		return uptime, counts, rate, dose
+
+class PulseDecoder:
+	def __init__(self):
+		self.last = None	# unwrapped timestamp of previous pulse
+		self.drops = None	# capture & link drop counters of previous frame
+
+	# returns list of unwrapped timestamps & number of pulses lost since the previous frame
+	def decode(self, payload):
+		if payload[0] != LOG_PULSES or len(payload) < 9:
+			return [], 0
+		drops = (int.from_bytes(payload[1:3], "little"), int.from_bytes(payload[3:5], "little"))
+		first = int.from_bytes(payload[5:9], "little")
+		lost = 0
+		if self.drops is not None:
+			lost = ((drops[0] - self.drops[0]) & 0xFFFF) + ((drops[1] - self.drops[1]) & 0xFFFF)
+		self.drops = drops
+		t = first if self.last is None else self.last + ((first - self.last) & 0xFFFFFFFF)
+		out = [t]
+		i = 9
+		while i < len(payload):
+			dt, i = get_varint(payload, i)
+			t += dt
+			out.append(t)
+		self.last = t
+		return out, lost
+
+def frames(stream):
+	# split on zero bytes, text lines show up as frames without valid CRC
+	buf = bytearray()
+	while True:
+		chunk = stream.read(1)
+		if not chunk:
+			return
+		if chunk[0] == 0:
+			if buf:
+				yield bytes(buf)
+			buf.clear()
+		else:
+			buf += chunk
+
+def main():
+	args = sys.argv[1:]
+	pulses = "-p" in args
+	random = "-r" in args
+	args = [a for a in args if a not in ("-p", "-r")]
+	path = args[0] if args else "-"
+	stream = sys.stdin.buffer if path == "-" else open(path, "rb")
+	log = LogDecoder()
+	pulse = PulseDecoder()
+	errors = 0
+	if not random:
+		print("timestamp" if pulses else "uptime,counts,rate,dose")
+	for enc in frames(stream):
+		payload = None
+		text = b""
+		# text lines printed between frames end up in front of the next frame
+		for start in [0] + [i + 1 for i, b in enumerate(enc) if b == 0x0A]:
+			try:
+				payload = check_frame(enc[start:])
+				text = enc[:start]
+				break
+			except (ValueError, IndexError):
+				continue
+		if text.strip():
+			sys.stderr.write(text.decode("ascii", "replace"))
+		if payload is None:
+			errors += 1
+			log.ref = None
+			text = enc.decode("ascii", "replace").strip()
+			if text:
+				sys.stderr.write(text + "\n")
+			continue
+		if payload[0] == LOG_RANDOM:
+			if random:
+				sys.stdout.buffer.write(payload[1:])
+			continue
+		if payload[0] == LOG_PULSES:
+			stamps, lost = pulse.decode(payload)
+			if lost:
+				sys.stderr.write("%u pulses lost\n" % lost)
+			if pulses and not random:
+				for t in stamps:
+					print(t)
+			continue
+		rec = log.decode(payload)
+		if rec and not (pulses or random):
+			print("%u,%u,%.3f,%.3f" % (rec[0], rec[1], rec[2]/1000, rec[3]/1000))
+	sys.stderr.write("%u invalid frames or text blocks\n" % errors)
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Generator for the dead-time correction tables in rad.c
+===============================================================================
+
+Models, with y = n*t (true rate) and x = m*t (measured rate):
+  non-paralyzable	x = y/(1+y)
+  paralyzable		x = y*exp(-y)
+  hybrid			x = y*exp(-a*y)/(1+(1-a)*y), a = 0.5
+
+Each table holds the correction factor n/m in Q12 for x = x_max*(1-(1-u)^2), u = 0..1 in
+RAD_DT_LUT_SIZE-1 steps. x_max is the measured rate at y = Y_MAX, the square-law spacing gives
+more entries close to saturation where the inverse gets steep.
+Beyond x_max the firmware computes the non-paralyzable factor 1/(1-x) up to FACTOR_MAX and flags
+everything else as over-range, the other models have no unique inverse there.
+The firmware lookup is emulated bit by bit and compared against the analytic inverse, the
+non-paralyzable check extends to the FACTOR_MAX limit.
+
+usage: python3 deadtime_lut.py, paste the tables into rad.c
+"""
+
+import math
+
+DEAD_TIME_US	= 190
+DEAD_TIME_Q24	= (DEAD_TIME_US*16777216 + 500000)//1000000
+LUT_SIZE		= 65
+Y_MAX			= 0.95		# largest corrected rate: 5kCPS with 190us
+HYBRID_A		= 0.5
+MODELS			= (("non-paralyzable", 0.0), ("paralyzable", 1.0), ("hybrid", HYBRID_A))
+FACTOR_MAX		= 65535		# Q12; RAD_DT_FACTOR_MAX
+RATE_MAX_Q8		= 0xFFFFFF
+
+def forward(y, a):
+	return y*math.exp(-a*y)/(1 + (1 - a)*y)
+
+def inverse(x, a):
+	lo, hi = 0.0, Y_MAX
+	for _ in range(100):
+		mid = (lo + hi)/2
+		if forward(mid, a) < x: lo = mid
+		else: hi = mid
+	return (lo + hi)/2
+
+def isqrt(x):
+	return math.isqrt(x)
+
+# emulation of CorrectDeadTime() in rad.c, cps in Q8, returns corrected Q8 value & over-range flag
+def correct(cps, lut, x_max, scale, nonpar):
+	ci, cf = cps >> 8, cps & 0xFF
+	x = ((ci*DEAD_TIME_Q24) >> 8) + ((cf*DEAD_TIME_Q24) >> 16)
+	f, over = lut[-1], False
+	if x >= x_max:
+		if nonpar and x < 65536 - 4096: f = 268435456//(65536 - x)
+		elif nonpar: f, over = FACTOR_MAX, True
+		else: over = True
+	else:
+		r = (x*scale) >> 12
+		if r > 65535: r = 65535
+		u = 32768 - isqrt((65536 - r) << 14)
+		i, frac = u >> 9, u & 0x1FF
+		f = lut[i] + (((lut[i + 1] - lut[i])*frac) >> 9)
+	corr = (ci*f + ((cf*f) >> 8) + 8) >> 4
+	if corr >= RATE_MAX_Q8: corr, over = RATE_MAX_Q8, True
+	return corr, over
+
+def main():
+	t = DEAD_TIME_Q24/16777216
+	x_maxs, scales, report = [], [], []
+	print("static const __flash uint16_t deadTimeLut[RAD_DT_MODEL_NUM][RAD_DT_LUT_SIZE] =\n{")
+	for name, a in MODELS:
+		x_max = forward(Y_MAX, a)
+		lut = []
+		for i in range(LUT_SIZE):
+			x = x_max*(1 - (1 - i/(LUT_SIZE - 1))**2)
+			lut.append(round(inverse(x, a)/x*4096) if x else 4096)
+		x_maxs.append(round(x_max*65536))
+		scales.append(round(4096/x_max))
+		
+		# accuracy check against the analytic model, true rate 1..5000CPS, non-paralyzable up to the factor limit
+		# the first over-range input must come right after the last one that is corrected
+		y_top = (FACTOR_MAX/4096 - 1) if a == 0.0 else Y_MAX
+		worst, worst_n, in_range = 0.0, 0, 0
+		for n in range(1, int(y_top/t) + 1):
+			m = forward(n*t, a)/t
+			got, over = correct(round(m*256), lut, x_maxs[-1], scales[-1], a == 0.0)
+			if over: break
+			in_range = n
+			err = abs(got/256/n - 1)
+			if err > worst: worst, worst_n = err, n
+		over_m = next(c for c in range(1 << 24) if correct(c << 8, lut, x_maxs[-1], scales[-1], a == 0.0)[1])
+		report.append("// %s: max. error %.3f%% @ %uCPS, corrected up to %uCPS, over-range from %uCPS measured"
+			% (name, worst*100, worst_n, in_range, over_m))
+		
+		rows = [", ".join("%5u" % v for v in lut[i:i + 13]) for i in range(0, LUT_SIZE, 13)]
+		print("\t{\t// " + name)
+		print(",\n".join("\t\t" + r for r in rows))
+		print("\t}," if a != MODELS[-1][1] else "\t}")
+	print("};")
+	print("static const __flash uint16_t deadTimeXMax[RAD_DT_MODEL_NUM] = {%s}; // Q16; x_max" % ", ".join("%uu" % v for v in x_maxs))
+	print("static const __flash uint16_t deadTimeScale[RAD_DT_MODEL_NUM] = {%s}; // Q12; 1/x_max" % ", ".join("%uu" % v for v in scales))
+	print("\n".join(report))
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Host replay benchmark of the dose rate filters in rad.c
+===============================================================================
+
+Replays Poisson counts per second through the fixed-point smoothing of ProcessData(), i.e. the EMA
+levels of RAD_filterLvls & the adaptive CUSUM filter (AdaptiveFactor(), CusumUpdate()), bit by bit.
+Dead-time correction is left out, it is negligible at these rates. For each background level:
+  sd		steady-state standard deviation of the estimate relative to the true rate [%]
+  resets/h	adaptive filter only: false step detections per hour at a constant rate
+  10x up, 2x up, 10x down
+			mean time after a rate step until the estimate is within 20% of the new rate [s]
+
+usage: python3 filter_bench.py [steady-state seconds] [step runs]
+
+expected output for the defaults, seeds are fixed:
+filter  rate/CPS   sd/%  resets/h  10x up/s  2x up/s  10x down/s
+0.20        0.40   52.7         -       6.9      4.4        11.0
+0.20        4.00   16.6         -       7.2      4.8        15.9
+0.20       40.00    5.3         -       7.2      4.7        17.2
+0.05        0.40   25.3         -      28.3     16.1        56.0
+0.05        4.00    8.0         -      29.8     18.5        69.1
+0.05       40.00    2.5         -      29.8     18.3        75.1
+0.02        0.40   15.9         -      73.8     44.8       155.7
+0.02        4.00    5.0         -      75.0     45.8       187.0
+0.02       40.00    1.6         -      74.9     45.5       191.1
+adapt       0.40    7.1      0.09       9.1     77.9       233.5
+adapt       4.00    3.0      0.55       1.8      6.4        35.7
+adapt      40.00    1.3      1.45       1.0      1.2         4.5
+"""
+
+import math
+import random
+import sys
+
+LN2_Q16			= 45426
+ADAPT_THRESHOLD	= 8 << 16
+ADAPT_MAX_WINDOW= 300
+FILTERS			= (("0.20", 13107), ("0.05", 3277), ("0.02", 1311), ("adapt", 0))
+RATES			= (0.4, 4.0, 40.0)
+STEPS			= (("10x up", 10.0), ("2x up", 2.0), ("10x down", 0.1))
+WARMUP			= 1000		# [s]; at the old rate before a step, longer than every filter's settling time
+STEP_MAX		= 2000		# [s]; latency is capped here
+MARGIN			= 0.2
+
+def mul_frac(a, b):
+	# MulFrac(): floor(a*b/2^16) without 64bit math
+	return (a >> 16)*b + (((a & 0xFFFF)*b) >> 16)
+
+class Cusum:
+	def __init__(self):
+		self.s, self.sum, self.len = 0, 0, 0
+
+	# CusumUpdate()
+	def update(self, gain, loss, cps):
+		if self.s + gain <= loss:
+			self.s, self.sum, self.len = 0, 0, 0
+			return False
+		self.s += gain - loss
+		if self.len < 255:
+			self.sum += cps >> 8
+			self.len += 1
+		return self.s > ADAPT_THRESHOLD
+
+class Filter:
+	def __init__(self, factor):
+		self.factor = factor
+		self.smooth = 0		# Q16
+		self.window = 0
+		self.up, self.down = Cusum(), Cusum()
+		self.resets = 0
+
+	# AdaptiveFactor()
+	def adaptive_factor(self, cps):
+		lam = self.smooth
+		cps_ln2 = mul_frac(cps, LN2_Q16)
+		c = None
+		if self.up.update(cps_ln2, lam, cps):
+			c = self.up
+		if self.down.update(lam >> 1, cps_ln2, cps):
+			c = self.down
+		if c is not None:
+			self.smooth = (c.sum//c.len) << 8
+			self.window = c.len
+			self.up, self.down = Cusum(), Cusum()
+			self.resets += 1
+			return 0
+		if self.window < ADAPT_MAX_WINDOW:
+			self.window += 1
+		return 65535//self.window
+
+	# smoothing part of ProcessData(), returns estimate in CPS
+	def step(self, counts):
+		cps = counts << 16
+		f = self.factor if self.factor else self.adaptive_factor(cps)
+		if cps > self.smooth:
+			self.smooth += mul_frac(cps - self.smooth, f)
+		else:
+			self.smooth -= mul_frac(self.smooth - cps, f)
+		return self.smooth/65536.0
+
+def poisson(rng, lam):
+	# Knuth for small, normal approximation for large means
+	if lam > 30:
+		return max(0, int(round(rng.gauss(lam, math.sqrt(lam)))))
+	l, k, p = math.exp(-lam), 0, 1.0
+	while True:
+		p *= rng.random()
+		if p <= l:
+			return k
+		k += 1
+
+def steady(factor, lam, secs):
+	rng = random.Random(7)
+	f = Filter(factor)
+	s1, s2, n = 0.0, 0.0, 0
+	for t in range(secs):
+		e = f.step(poisson(rng, lam))
+		if t >= WARMUP:
+			s1 += e
+			s2 += e*e
+			n += 1
+	mean = s1/n
+	sd = math.sqrt(max(0.0, s2/n - mean*mean))
+	return 100.0*sd/lam, f.resets*3600.0/secs
+
+def latency(factor, lam, ratio, runs):
+	rng = random.Random(11)
+	total = 0
+	for _ in range(runs):
+		f = Filter(factor)
+		for _ in range(WARMUP):
+			f.step(poisson(rng, lam))
+		target = lam*ratio
+		t = 1
+		while t < STEP_MAX and abs(f.step(poisson(rng, target)) - target) >= MARGIN*target:
+			t += 1
+		total += t
+	return total/runs
+
+def main():
+	secs = int(sys.argv[1]) if len(sys.argv) > 1 else 360000
+	runs = int(sys.argv[2]) if len(sys.argv) > 2 else 100
+	print("filter  rate/CPS   sd/%  resets/h  " + "  ".join("%s/s" % name for name, _ in STEPS))
+	for name, factor in FILTERS:
+		for lam in RATES:
+			sd, resets = steady(factor, lam, secs)
+			lat = [latency(factor, lam, ratio, runs) for _, ratio in STEPS]
+			print("%-6s  %8.2f  %5.1f  %8s  %8.1f  %7.1f  %10.1f" % (name, lam, sd,
+				("%.2f" % resets) if not factor else "-", *lat))
+
+if __name__ == "__main__":
+	main()
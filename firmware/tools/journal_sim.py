@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Host test of the total dose journal in rad.c against an emulated EEPROM
+===============================================================================
+
+Emulates LoadJournal() / WriteJournal() byte by byte on a 1KB EEPROM with per cell write counters:
+  endurance	checkpoints every RAD_JOURNAL_INTERVAL for the given number of years, worst cell wear
+  recovery	power is cut at a random byte of a checkpoint write, the cut byte is garbage,
+			boot must restore either the previous or the new dose, never anything else
+  wrap		sequence number wrap around at 2^16 checkpoints
+
+usage: python3 journal_sim.py [years]
+"""
+
+import random
+import struct
+import sys
+
+JOURNAL_START	= 0x100
+JOURNAL_SIZE	= 0x300
+SLOT_SIZE		= 8
+SLOT_NUM		= JOURNAL_SIZE//SLOT_SIZE
+INTERVAL		= 300
+ENDURANCE		= 100000	# datasheet write/erase cycles per cell
+
+def crc_ccitt_update(crc, data):
+	# avr-libc _crc_ccitt_update()
+	data ^= crc & 0xFF
+	data = (data ^ (data << 4)) & 0xFF
+	return ((data << 8) | (crc >> 8)) ^ (data >> 4) ^ (data << 3)
+
+def journal_crc(raw):
+	crc = 0xFFFF
+	for b in raw[:6]:
+		crc = crc_ccitt_update(crc, b)
+	return crc & 0xFFFF
+
+class Eeprom:
+	def __init__(self):
+		self.mem = bytearray([0xFF]*1024)
+		self.wear = [0]*1024
+		self.cut = None		# number of byte writes until power is cut
+
+	# eeprom_update_block(): only changed bytes are written
+	def update(self, addr, data, rng=None):
+		for i, b in enumerate(data):
+			if self.mem[addr + i] == b:
+				continue
+			if self.cut is not None:
+				if self.cut == 0:
+					self.mem[addr + i] = rng.randrange(256) # torn byte
+					raise PowerCut
+				self.cut -= 1
+			self.mem[addr + i] = b
+			self.wear[addr + i] += 1
+
+class PowerCut(Exception):
+	pass
+
+class Journal:
+	def __init__(self, eep):
+		self.eep = eep
+		self.idx = 0
+		self.seq = 0
+
+	def load(self):
+		found, newest = False, None
+		self.idx = self.seq = 0
+		for i in range(SLOT_NUM):
+			raw = self.eep.mem[JOURNAL_START + i*SLOT_SIZE:][:SLOT_SIZE]
+			seq, dose, crc = struct.unpack("<HIH", raw)
+			if crc != journal_crc(raw):
+				continue
+			diff = (seq - newest[0]) & 0xFFFF if found else 1
+			if diff == 0 or diff >= 0x8000: # (int16_t)(seq - newest) <= 0
+				continue
+			found, newest = True, (seq, dose)
+			self.idx = (i + 1) % SLOT_NUM
+			self.seq = (seq + 1) & 0xFFFF
+		return newest[1] if found else None
+
+	def write(self, dose, rng=None):
+		raw = bytearray(struct.pack("<HIH", self.seq, dose, 0))
+		raw[6:8] = struct.pack("<H", journal_crc(raw))
+		self.eep.update(JOURNAL_START + self.idx*SLOT_SIZE, raw, rng)
+		self.seq = (self.seq + 1) & 0xFFFF
+		self.idx = (self.idx + 1) % SLOT_NUM
+
+def endurance(years):
+	eep = Eeprom()
+	j = Journal(eep)
+	j.load()
+	dose = 0
+	writes = int(years*365*24*3600/INTERVAL)
+	for _ in range(writes):
+		dose += 1 # dose changes every interval, worst case
+		j.write(dose)
+	worst = max(eep.wear)
+	print("endurance: %.0f years, %u checkpoints, worst cell %u writes (%.1f%% of %u)"
+		  % (years, writes, worst, 100.0*worst/ENDURANCE, ENDURANCE))
+	print("           lifetime at worst cell: %.0f years" % (years*ENDURANCE/worst))
+	assert j.load() == dose
+
+def recovery(runs):
+	rng = random.Random(1)
+	eep = Eeprom()
+	j = Journal(eep)
+	assert j.load() is None, "erased EEPROM must not contain a valid slot"
+	dose, fails, torn = 0, 0, 0
+	for _ in range(runs):
+		new = (dose + rng.randrange(1, 1 << 24)) & 0xFFFFFFFF
+		eep.cut = rng.randrange(SLOT_SIZE + 2) # sometimes completes
+		try:
+			j.write(new, rng)
+			dose = new
+		except PowerCut:
+			torn += 1
+		eep.cut = None
+		got = Journal(eep)
+		restored = got.load()
+		if restored not in (dose, new):
+			fails += 1
+		# boot continues with the restored value
+		dose = restored
+		j = got
+	print("recovery:  %u boots, %u torn writes, %u wrong restores" % (runs, torn, fails))
+	assert not fails
+
+def wrap():
+	eep = Eeprom()
+	j = Journal(eep)
+	j.load()
+	for dose in range(70000):
+		j.write(dose)
+		if dose % 997 == 0 or 65530 < dose < 65600:
+			assert Journal(eep).load() == dose, dose
+	print("wrap:      70000 checkpoints across seq wrap around restored ok")
+
+if __name__ == "__main__":
+	years = float(sys.argv[1]) if len(sys.argv) > 1 else 20
+	endurance(years)
+	recovery(20000)
+	wrap()
@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+"""
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Host check of the GM tube entropy pipeline & ChaCha20 DRBG in rng.c
+===============================================================================
+
+Emulates rng.c bit by bit: interval comparison, health tests, von Neumann debiasing, pool,
+reseed & fast key erasure of the DRBG, ChaChaBlock() with zero nonce.
+  vectors	ChaChaBlock() against the RFC 8439 A.1 test vectors with zero nonce (#1-#4)
+  reseed	exponential intervals plus dead time at several count rates:
+			first seed after boot (incl. the APT startup window) & mean interval between reseeds [s],
+			output bits per interval & health test failures
+
+usage: python3 rng_sim.py [reseeds per rate]
+
+expected output, seeds are fixed:
+RFC 8439 A.1 #1: OK
+RFC 8439 A.1 #2: OK
+RFC 8439 A.1 #3: OK
+RFC 8439 A.1 #4: OK
+
+rate/CPS  first_seed/s  reseed/s  bits/interval  failures
+     0.3         13675    6812.9          0.124         0
+       1          4163    2021.4          0.125         0
+      10           398     205.2          0.124         0
+     100            41      20.7          0.125         0
+    1000             5       2.5          0.124         0
+"""
+
+import random
+import struct
+import sys
+
+RCT_CUTOFF		= 26
+APT_WINDOW		= 1024
+APT_CUTOFF		= 664
+POOL_SIZE		= 64
+SEED_SIZE		= 32
+DEAD_TIME		= 210e-6	# [s]; SBM-20 incl. pulse amp
+RATES			= (0.3, 1.0, 10.0, 100.0, 1000.0)
+SIGMA			= (0x61707865, 0x3320646E, 0x79622D32, 0x6B206574)
+
+# RFC 8439 A.1: key, block counter, first keystream block (nonce is zero for #1-#4)
+VECTORS = (
+	(bytes(32), 0,
+		"76b8e0ada0f13d90405d6ae55386bd28bdd219b8a08ded1aa836efcc8b770dc7"
+		"da41597c5157488d7724e03fb8d84a376a43b8f41518a11cc387b669b2ee6586"),
+	(bytes(32), 1,
+		"9f07e7be5551387a98ba977c732d080dcb0f29a048e3656912c6533e32ee7aed"
+		"29b721769ce64e43d57133b074d839d531ed1f28510afb45ace10a1f4b794d6f"),
+	(bytes(31) + b"\x01", 1,
+		"3aeb5224ecf849929b9d828db1ced4dd832025e8018b8160b82284f3c949aa5a"
+		"8eca00bbb4a73bdad192b5c42f73f2fd4e273644c8b36125a64addeb006c13a0"),
+	(b"\x00\xff" + bytes(30), 2,
+		"72d54dfbf12ec44b362692df94137f328fea8da73990265ec1bbbea1ae9af0ca"
+		"13b25aa26cb4a648cb9b9d1be65b2c0924a66c54d545ec1b7374f4872e99f096"),
+)
+
+def rotl(x, n):
+	return ((x << n) | (x >> (32 - n))) & 0xFFFFFFFF
+
+def quarter(x, a, b, c, d):
+	x[a] = (x[a] + x[b]) & 0xFFFFFFFF; x[d] = rotl(x[d] ^ x[a], 16)
+	x[c] = (x[c] + x[d]) & 0xFFFFFFFF; x[b] = rotl(x[b] ^ x[c], 12)
+	x[a] = (x[a] + x[b]) & 0xFFFFFFFF; x[d] = rotl(x[d] ^ x[a], 8)
+	x[c] = (x[c] + x[d]) & 0xFFFFFFFF; x[b] = rotl(x[b] ^ x[c], 7)
+
+# ChaChaBlock(), key as 8 little endian words
+def chacha_block(key, counter):
+	x = list(SIGMA) + list(key) + [counter & 0xFFFFFFFF, 0, 0, 0]
+	s = list(x)
+	for _ in range(10):
+		quarter(x, 0, 4, 8, 12); quarter(x, 1, 5, 9, 13); quarter(x, 2, 6, 10, 14); quarter(x, 3, 7, 11, 15)
+		quarter(x, 0, 5, 10, 15); quarter(x, 1, 6, 11, 12); quarter(x, 2, 7, 8, 13); quarter(x, 3, 4, 9, 14)
+	return struct.pack("<16I", *((x[i] + s[i]) & 0xFFFFFFFF for i in range(16)))
+
+class Rng:
+	def __init__(self):
+		self.pair, self.pair_pending = 0, False
+		self.vn_bit, self.vn_pending = False, False
+		self.rct_bit, self.rct_count = False, 0
+		self.apt_bit, self.apt_count, self.apt_idx = False, 0, 0
+		self.ready = False
+		self.failures = 0
+		self.pool = []
+		self.accu, self.accu_bits = 0, 0
+		self.key = [0]*8
+		self.seeded = False
+		self.reseeds = 0
+		self.bits = 0
+
+	# RNG_AddInterval()
+	def add_interval(self, interval):
+		if not self.pair_pending:
+			self.pair, self.pair_pending = interval, True
+			return
+		self.pair_pending = False
+		if interval == self.pair:
+			return
+		bit = self.pair > interval
+		if not self.health_test(bit) or not self.ready:
+			return
+		if not self.vn_pending:
+			self.vn_bit, self.vn_pending = bit, True
+			return
+		self.vn_pending = False
+		if self.vn_bit != bit:
+			self.put_bit(self.vn_bit)
+
+	# HealthTest()
+	def health_test(self, bit):
+		ok = True
+		if self.rct_count and bit == self.rct_bit:
+			self.rct_count += 1
+			if self.rct_count >= RCT_CUTOFF: ok = False
+		else:
+			self.rct_bit, self.rct_count = bit, 1
+		if not self.apt_idx:
+			self.apt_bit, self.apt_count = bit, 0
+		if bit == self.apt_bit:
+			self.apt_count += 1
+			if self.apt_count >= APT_CUTOFF: ok = False
+		self.apt_idx += 1
+		if self.apt_idx == APT_WINDOW:
+			self.apt_idx = 0
+			if ok: self.ready = True
+		if ok:
+			return True
+		self.failures += 1
+		self.ready = False
+		self.rct_count, self.apt_idx = 0, 0
+		self.vn_pending = False
+		self.accu_bits = 0
+		self.pool = []
+		return False
+
+	# PutBit(), bulk mode off
+	def put_bit(self, bit):
+		self.bits += 1
+		self.accu = ((self.accu << 1) | bit) & 0xFF
+		self.accu_bits += 1
+		if self.accu_bits < 8:
+			return
+		self.accu_bits = 0
+		if len(self.pool) < POOL_SIZE:
+			self.pool.append(self.accu)
+		if len(self.pool) >= SEED_SIZE:
+			self.reseed()
+
+	# Reseed() & Rekey()
+	def reseed(self):
+		key = bytearray(struct.pack("<8I", *self.key))
+		for i in range(SEED_SIZE):
+			key[i] ^= self.pool.pop(0)
+		self.key = list(struct.unpack("<8I", chacha_block(struct.unpack("<8I", key), 0)[:32]))
+		self.seeded = True
+		self.reseeds += 1
+
+def main():
+	seeds = int(sys.argv[1]) if len(sys.argv) > 1 else 100
+
+	for n, (key, counter, expected) in enumerate(VECTORS, 1):
+		got = chacha_block(struct.unpack("<8I", key), counter).hex()
+		print("RFC 8439 A.1 #%u: %s" % (n, "OK" if got == expected else "FAILED " + got))
+
+	print("\nrate/CPS  first_seed/s  reseed/s  bits/interval  failures")
+	rng = random.Random(88172645463325252)
+	for rate in RATES:
+		r = Rng()
+		t, first, last, total, reseeds, intervals = 0.0, None, None, 0.0, 0, 0
+		while reseeds < seeds:
+			iv = DEAD_TIME + rng.expovariate(rate)
+			t += iv
+			intervals += 1
+			before = r.reseeds
+			r.add_interval(int(iv*1e6))
+			if r.reseeds == before:
+				continue
+			if first is None:
+				first = t
+			else:
+				total += t - last
+				reseeds += 1
+			last = t
+		print("%8g  %12.0f  %8.1f  %13.3f  %8u" % (rate, first, total/reseeds, r.bits/intervals, r.failures))
+
+if __name__ == "__main__":
+	main()
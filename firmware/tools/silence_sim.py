@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+===============================================================================
+ Project	: O.S.I.R.I.S.
+ Author		: Nicolai Sawilla (0xCAFEAFFE)
+ Licence	: GNU GPL v2
+ Version	: v2.0 (PCB Rev 2.0)
+ Content	: Host simulation of the rate-adaptive silence test in RAD_DetectorCheck()
+===============================================================================
+
+Emulates the fixed-point rate EWMA & silence limit of rad.c bit by bit, fed with Poisson counts
+per second. For each background level it reports:
+  limit		silence limit at the learned rate [s]
+  latency	mean & max time from tube failure to fault [s]
+  false/h	false faults per hour of healthy operation, measured & expected for the exact rate
+		(silent periods per hour * exp(-rate*limit), the 300s cap only applies below 0.05CPS)
+
+Rate steps down from a high level to background after the rate was learned for 10min, reported for
+the 10min after the step, averaged over repeated runs:
+  faults	fault episodes, with the gap cap of rad.c & with the plain EWMA for comparison
+  fault_s	seconds spent in fault state, RAD_EngineTick() skips dose processing for these
+
+usage: python3 silence_sim.py [hours per level]
+"""
+
+import math
+import random
+import sys
+
+MAX_PULSE_INTERVAL	= 300
+LN_Q16				= int(13.816*65536)
+GAP_LN_Q16			= int(4.605*65536)
+RATE_SHIFT			= 6
+RATES				= (0.05, 0.1, 0.3, 1.0, 3.0, 10.0, 100.0)
+FAIL_RUNS			= 200
+STEPS				= ((100.0, 0.3), (100.0, 0.05), (10.0, 0.3), (1000.0, 1.0), (3.0, 0.1))
+STEP_RUNS			= 200
+
+class Detector:
+	def __init__(self, gap_cap=True):
+		self.rate = 0
+		self.silent = 0
+		self.limit = MAX_PULSE_INTERVAL
+		self.gap_cap = gap_cap
+
+	# one call per second, returns False on fault
+	def check(self, counts):
+		if counts:
+			if self.silent and self.gap_cap:
+				self.rate = min(self.rate, GAP_LN_Q16//self.silent)
+			self.silent = 0
+			lim = (LN_Q16 + self.rate - 1)//self.rate if self.rate else MAX_PULSE_INTERVAL
+			self.limit = min(lim, MAX_PULSE_INTERVAL)
+		else:
+			self.silent += 1
+		self.rate += int(((counts << 16) - self.rate) / (1 << RATE_SHIFT)) # C division truncates
+		return self.silent < self.limit
+
+def poisson(rng, lam):
+	# Knuth for small, normal approximation for large means
+	if lam > 30:
+		return max(0, int(round(rng.gauss(lam, math.sqrt(lam)))))
+	l, k, p = math.exp(-lam), 0, 1.0
+	while True:
+		p *= rng.random()
+		if p <= l:
+			return k
+		k += 1
+
+def main():
+	hours = float(sys.argv[1]) if len(sys.argv) > 1 else 100
+	rng = random.Random(1)
+	print("rate/CPS  limit/s  lat_mean/s  lat_max/s  false/h  expected/h")
+	for lam in RATES:
+		# false alarms, a fault episode ends with the next pulse
+		d = Detector()
+		faults, in_fault = 0, False
+		for _ in range(int(hours*3600)):
+			ok = d.check(poisson(rng, lam))
+			if not ok and not in_fault:
+				faults += 1
+			in_fault = not ok
+		limit = d.limit
+		exact = min(math.ceil(13.816/lam), MAX_PULSE_INTERVAL)
+		expected = 3600*(1 - math.exp(-lam))*math.exp(-lam)*math.exp(-lam*exact)
+
+		# latency after tube failure, rate learned for 10min before, fault is reported by the tick of the last silent second
+		lat = []
+		for _ in range(FAIL_RUNS):
+			d = Detector()
+			for _ in range(600):
+				d.check(poisson(rng, lam))
+			t = 0
+			while d.check(0):
+				t += 1
+			lat.append(t + 1)
+		print("%8.2f  %7u  %10.1f  %9u  %7.4f  %10.4f" % (lam, limit, sum(lat)/len(lat), max(lat), faults/hours, expected))
+
+	print("\nstep/CPS        faults  fault_s  faults_ewma  fault_s_ewma")
+	for hi, lo in STEPS:
+		res = []
+		for cap in (True, False):
+			faults, secs = 0, 0
+			for _ in range(STEP_RUNS):
+				d = Detector(cap)
+				for _ in range(600):
+					d.check(poisson(rng, hi))
+				in_fault = False
+				for _ in range(600):
+					ok = d.check(poisson(rng, lo))
+					if not ok:
+						secs += 1
+						if not in_fault:
+							faults += 1
+					in_fault = not ok
+			res += [faults/STEP_RUNS, secs/STEP_RUNS]
+		print("%6g->%-6g  %6.2f  %7.1f  %11.2f  %12.1f" % (hi, lo, *res))
+
+if __name__ == "__main__":
+	main()